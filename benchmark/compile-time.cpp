@@ -5,15 +5,34 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "ctf/batch.hpp"
+#include "ctf/batch_parallel.hpp"
+#include "ctf/bytes.hpp"
+#include "ctf/fixed.hpp"
 #include "ctf/format.hpp"
+#include "ctf/units.hpp"
 
 #include <nanobench.h>
 
 #include <chrono>
+#include <cstdint>
 #include <fstream>
+#include <iostream>
+#include <thread>
+#include <tuple>
+#include <vector>
 
 namespace {
 
+// Reports the unused capacity of the strings returned by ctf::format and
+// ctf::format_exact.
+void report_capacity(const char *name, const std::string &format,
+                     const std::string &exact) {
+  std::cout << "| " << name << " | " << format.size() << " | "
+            << format.capacity() << " | " << exact.capacity() << " | "
+            << format.capacity() - exact.capacity() << " |\n";
+}
+
 void generate_output(const std::string &extension, char const *output_template,
                      const ankerl::nanobench::Bench &bench) {
   std::ofstream output("compile-time.render." + extension);
@@ -63,6 +82,167 @@ int main() {
     });
   }
 
+  bench.run("longer text exact", [&] {
+    std::string s =
+        ctf::format_exact<"Checked out {} items for a total price of {}.">(
+            42, std::numeric_limits<double>::infinity());
+    ankerl::nanobench::doNotOptimizeAway(s);
+  });
+
+  // Formatting to a null_sink measures the cost of formatting without the
+  // cost of storing the output.
+  bench.run("answer null sink", [&] {
+    ctf::null_sink sink;
+    ctf::format_to<"answer{}">(sink, 42);
+    ankerl::nanobench::doNotOptimizeAway(sink);
+  });
+  bench.run("longer text null sink", [&] {
+    ctf::null_sink sink;
+    ctf::format_to<"Checked out {} items for a total price of {}.">(
+        sink, 42, std::numeric_limits<double>::infinity());
+    ankerl::nanobench::doNotOptimizeAway(sink);
+  });
+
+  // ctf::format appends with a std::back_insert_iterator, a string_sink is
+  // written by a sink_iterator, which calls write for every element written by
+  // a formatter. Compare with "answer" and "longer text".
+  bench.run("answer string sink", [&] {
+    std::string s;
+    ctf::string_sink sink{s};
+    ctf::format_to<"answer{}">(sink, 42);
+    ankerl::nanobench::doNotOptimizeAway(s);
+  });
+  bench.run("longer text string sink", [&] {
+    std::string s;
+    ctf::string_sink sink{s};
+    ctf::format_to<"Checked out {} items for a total price of {}.">(
+        sink, 42, std::numeric_limits<double>::infinity());
+    ankerl::nanobench::doNotOptimizeAway(s);
+  });
+
+  {
+    // Formatting all rows at once avoids the allocation per row.
+    std::vector<std::tuple<int, double>> rows;
+    for (int i = 0; i != 100; ++i)
+      rows.emplace_back(i, i * 0.25);
+
+    bench.run("100 rows", [&] {
+      std::string s;
+      for (const auto &[id, value] : rows)
+        s += ctf::format<"{},{}\n">(id, value);
+      ankerl::nanobench::doNotOptimizeAway(s);
+    });
+    bench.run("100 rows batch", [&] {
+      std::string s;
+      ctf::format_batch<"{},{}\n">(s, rows);
+      ankerl::nanobench::doNotOptimizeAway(s);
+    });
+  }
+
+  {
+    // A string with a few characters to escape, the other blocks are copied
+    // unchanged.
+    std::string text(1000, 'x');
+    text[100] = '"';
+    text[700] = '\n';
+    bench.run("1000 chars", [&] {
+      std::string s = ctf::format<"{}">(text);
+      ankerl::nanobench::doNotOptimizeAway(s);
+    });
+    bench.run("1000 chars json escaped", [&] {
+      std::string s = ctf::format<"{:j}">(text);
+      ankerl::nanobench::doNotOptimizeAway(s);
+    });
+  }
+
+  {
+    ankerl::nanobench::Bench bytes;
+    bytes.title("Bytes");
+
+    std::vector<unsigned char> data(4096);
+    for (std::size_t i = 0; i != data.size(); ++i)
+      data[i] = i * 31;
+    bytes.run("4096 bytes hex", [&] {
+      std::string s = ctf::format<"{}">(ctf::bytes(data));
+      ankerl::nanobench::doNotOptimizeAway(s);
+    });
+    bytes.run("4096 bytes base64", [&] {
+      std::string s = ctf::format<"{:b}">(ctf::bytes(data));
+      ankerl::nanobench::doNotOptimizeAway(s);
+    });
+  }
+
+  {
+    // An amount in cents, converted to a floating-point value or formatted
+    // as a fixed-point value.
+    std::int64_t cents = 123'456'789;
+    bench.run("cents as double", [&] {
+      std::string s = ctf::format<"{:.2f}">(cents / 100.0);
+      ankerl::nanobench::doNotOptimizeAway(s);
+    });
+    bench.run("cents as fixed<2>", [&] {
+      std::string s = ctf::format<"{}">(ctf::fixed<2>(cents));
+      ankerl::nanobench::doNotOptimizeAway(s);
+    });
+  }
+
+  {
+    // A size in binary units, formatted with a helper function or the unit
+    // display type.
+    std::uint64_t size = 1'288'490'189;
+    bench.run("size helper", [&] {
+      const char *units[] = {"B", "KiB", "MiB", "GiB", "TiB", "PiB", "EiB"};
+      double value = size;
+      int unit = 0;
+      for (; value >= 1024 && unit != 6; ++unit)
+        value /= 1024;
+      std::string s = ctf::format<"{:.1f} {}">(value, units[unit]);
+      ankerl::nanobench::doNotOptimizeAway(s);
+    });
+    bench.run("size {:iB}", [&] {
+      std::string s = ctf::format<"{:iB}">(size);
+      ankerl::nanobench::doNotOptimizeAway(s);
+    });
+  }
+
+  {
+    // The scaling of a large batch with the number of threads.
+    ankerl::nanobench::Bench parallel;
+    parallel.title("Parallel batch").relative(true).minEpochIterations(5);
+
+    std::vector<std::tuple<int, double>> rows;
+    for (int i = 0; i != 200'000; ++i)
+      rows.emplace_back(i, i * 0.25);
+
+    parallel.run("200000 rows batch", [&] {
+      std::string s;
+      ctf::format_batch<"{},{}\n">(s, rows);
+      ankerl::nanobench::doNotOptimizeAway(s);
+    });
+    for (std::size_t threads = 2;
+         threads <= std::max(std::thread::hardware_concurrency(), 2u);
+         threads *= 2)
+      parallel.run(ctf::format<"200000 rows {} threads">(threads), [&] {
+        std::string s;
+        ctf::format_batch_parallel<"{},{}\n">(s, rows, threads);
+        ankerl::nanobench::doNotOptimizeAway(s);
+      });
+  }
+
+  std::cout << "\n| name | size | capacity | exact capacity | saved bytes |\n"
+               "|------|-----:|---------:|---------------:|------------:|\n";
+  report_capacity(
+      "longer text",
+      ctf::format<"Checked out {} items for a total price of {}.">(
+          42, std::numeric_limits<double>::infinity()),
+      ctf::format_exact<"Checked out {} items for a total price of {}.">(
+          42, std::numeric_limits<double>::infinity()));
+  {
+    std::string row(200, '*');
+    report_capacity("row", ctf::format<"{}|{:>10}|{}">(row, 42, row),
+                    ctf::format_exact<"{}|{:>10}|{}">(row, 42, row));
+  }
+
   generate_output("html", ankerl::nanobench::templates::htmlBoxplot(), bench);
   generate_output("json", ankerl::nanobench::templates::json(), bench);
 }
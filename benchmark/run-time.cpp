@@ -6,6 +6,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "ctf/format.hpp"
+#include "ctf/runtime_format.hpp"
 
 #include <nanobench.h>
 
@@ -43,6 +44,30 @@ int main() {
     ankerl::nanobench::doNotOptimizeAway(s);
   });
 
+  {
+    // A format string known at run-time. ctf::runtime_format parses it once,
+    // std::vformat parses it on every call.
+    std::string fmt = "Checked out {} items for a total price of {}.";
+    int items = 42;
+    double price = std::numeric_limits<double>::infinity();
+    bench.run("longer text vformat", [&] {
+      std::string s = std::vformat(fmt, std::make_format_args(items, price));
+      ankerl::nanobench::doNotOptimizeAway(s);
+    });
+    // ctf::runtime_format appends to the string with a back_insert_iterator,
+    // a string_sink is written through a sink_iterator.
+    bench.run("longer text runtime_format", [&] {
+      std::string s = ctf::runtime_format(fmt, items, price);
+      ankerl::nanobench::doNotOptimizeAway(s);
+    });
+    bench.run("longer text runtime_format_to string sink", [&] {
+      std::string s;
+      ctf::string_sink sink{s};
+      ctf::runtime_format_to(sink, fmt, items, price);
+      ankerl::nanobench::doNotOptimizeAway(s);
+    });
+  }
+
   {
     using namespace std::literals::chrono_literals;
     std::chrono::sys_seconds time{2'000'000'000s};
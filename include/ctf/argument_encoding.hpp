@@ -0,0 +1,108 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CTF_ARGUMENT_ENCODING_HPP
+#define CTF_ARGUMENT_ENCODING_HPP
+
+#include "format.hpp"
+#include "sink.hpp"
+#include "utility.hpp"
+
+#include <concepts>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+// The binary encoding of the arguments used to format them later.
+//
+// String arguments are stored as their size followed by their code units, the
+// other arguments are copied with memcpy. The arguments are not aligned.
+//
+// Only values are copied with memcpy. Other types, like spans and pointers,
+// refer to memory that is no longer valid when the record is decoded.
+namespace ctf::detail {
+
+template <class T>
+concept string_argument = std::same_as<format_arg_t<char, T>, std::string_view>;
+
+template <class T>
+concept capturable = string_argument<T> || std::is_arithmetic_v<T> ||
+                     std::is_enum_v<T> || std::same_as<T, const void *> ||
+                     std::same_as<T, void *> || std::same_as<T, std::nullptr_t>;
+
+// The type of the argument after decoding.
+template <class T>
+using decoded_t = std::conditional_t<string_argument<T>, std::string_view, T>;
+
+template <class T> std::size_t encoded_size(T &arg) {
+  if constexpr (string_argument<std::remove_cvref_t<T>>)
+    return sizeof(std::size_t) + ctf::as_format_arg<char>(arg).size();
+  else
+    return sizeof(T);
+}
+
+template <class T> void encode(std::byte *&data, T &arg) {
+  if constexpr (string_argument<std::remove_cvref_t<T>>) {
+    std::string_view value = ctf::as_format_arg<char>(arg);
+    std::size_t size = value.size();
+    std::memcpy(data, &size, sizeof(size));
+    std::memcpy(data + sizeof(size), value.data(), size);
+    data += sizeof(size) + size;
+  } else {
+    std::memcpy(data, std::addressof(arg), sizeof(T));
+    data += sizeof(T);
+  }
+}
+
+// Throws std::runtime_error when the argument is not inside the record.
+template <class T>
+decoded_t<T> decode_arg(const std::byte *&data, const std::byte *end) {
+  if constexpr (string_argument<T>) {
+    std::size_t size;
+    if (std::size_t(end - data) < sizeof(size))
+      throw std::runtime_error("truncated argument");
+    std::memcpy(&size, data, sizeof(size));
+    data += sizeof(size);
+    if (std::size_t(end - data) < size)
+      throw std::runtime_error("truncated argument");
+    std::string_view result{reinterpret_cast<const char *>(data), size};
+    data += size;
+    return result;
+  } else {
+    if (std::size_t(end - data) < sizeof(T))
+      throw std::runtime_error("truncated argument");
+    // The arguments are not aligned in the record.
+    std::remove_const_t<T> result;
+    std::memcpy(&result, data, sizeof(T));
+    data += sizeof(T);
+    return result;
+  }
+}
+
+// Decodes the arguments of the record [data, end) and writes the formatted
+// output.
+using record_decoder = void (*)(const std::byte *, const std::byte *,
+                                fd_sink &);
+
+// The decoder of a call site.
+//
+// The strings point in the record, so they are valid while formatting.
+template <fixed_string fmt, class... Args>
+void decode_record(const std::byte *data, const std::byte *end,
+                   fd_sink &out) {
+  // The braced initializer decodes the arguments from left to right.
+  std::tuple<decoded_t<Args>...> args{decode_arg<Args>(data, end)...};
+  std::apply([&](auto &...a) { ctf::format_to<fmt>(out, a...); }, args);
+}
+
+} // namespace ctf::detail
+
+#endif // CTF_ARGUMENT_ENCODING_HPP
@@ -0,0 +1,190 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CTF_BATCH_HPP
+#define CTF_BATCH_HPP
+
+#include "format.hpp"
+#include "sink.hpp"
+#include "utility.hpp"
+
+#include <concepts>
+#include <cstddef>
+#include <exception>
+#include <iterator>
+#include <ranges>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace ctf {
+
+// The output of a batch with the position of every row.
+//
+// Element i of offsets is the offset past the end of row i in text, so row i
+// starts at offsets[i - 1], or at 0 for the first row.
+struct batch_output {
+  std::string text;
+  std::vector<std::size_t> offsets;
+};
+
+namespace detail {
+
+// Appends the output of rows rows to out.
+//
+// row(i, f) calls f with the arguments of row i. When offsets is not nullptr
+// the end of every row is appended to it.
+template <fixed_string fmt, class... Args, class Row>
+void format_rows(std::string &out, std::vector<std::size_t> *offsets,
+                 std::size_t rows, Row row) {
+  constexpr auto status = parse<fmt, Args...>();
+
+  if constexpr (ctf::is_format_error(status))
+    static_assert(!"parse error", status);
+  else {
+    if (offsets)
+      offsets->reserve(offsets->size() + rows);
+
+    constexpr max_size_result bound = ctf::max_size<fmt>(status.tokens);
+    std::size_t size = out.size();
+    if constexpr (bound.size != unbounded) {
+      // Writes directly in the string, the unused part is not initialized.
+      // The operation may not throw, so the exception is rethrown afterwards.
+      const std::size_t first = size;
+      const std::size_t capacity = out.capacity();
+      std::exception_ptr error;
+      out.resize_and_overwrite(
+          size + rows * bound.size, [&](char *data, std::size_t) noexcept {
+            try {
+              for (std::size_t i = 0; i != rows; ++i) {
+                size = row(i, [&](const auto &...args) {
+                         return ctf::format_tokens_to<fmt>(
+                             data + size, status.tokens, args...);
+                       }) -
+                       data;
+                if (offsets)
+                  offsets->push_back(size);
+              }
+            } catch (...) {
+              // Keeps the rows written before the exception.
+              error = std::current_exception();
+            }
+            return size;
+          });
+
+      // The string keeps the capacity of the worst case, unless the unused
+      // part is larger than the output of the rows.
+      if (out.capacity() > capacity &&
+          out.capacity() - out.size() > out.size() - first)
+        out.shrink_to_fit();
+      if (error)
+        std::rethrow_exception(error);
+    } else {
+      try {
+        string_sink{out}.reserve(rows * ctf::reserve_size<fmt>(status.tokens));
+        for (std::size_t i = 0; i != rows; ++i) {
+          row(i, [&](const auto &...args) {
+            return ctf::format_tokens_to<fmt>(std::back_inserter(out),
+                                              status.tokens, args...);
+          });
+          size = out.size();
+          if (offsets)
+            offsets->push_back(size);
+        }
+      } catch (...) {
+        // Keeps the rows written before the exception.
+        out.resize(size);
+        throw;
+      }
+    }
+  }
+}
+
+template <fixed_string fmt, class R>
+void format_batch(std::string &out, std::vector<std::size_t> *offsets,
+                  const R &rows) {
+  using T = std::ranges::range_value_t<R>;
+  auto first = std::ranges::begin(rows);
+  [&]<std::size_t... I>(std::index_sequence<I...>) {
+    detail::format_rows<fmt, const std::tuple_element_t<I, T> &...>(
+        out, offsets, std::ranges::size(rows),
+        [&](std::size_t i, auto f) { return std::apply(f, first[i]); });
+  }(std::make_index_sequence<std::tuple_size_v<T>>());
+}
+
+template <fixed_string fmt, class... Columns>
+void format_columns(std::string &out, std::vector<std::size_t> *offsets,
+                    const Columns &...columns) {
+  const std::size_t sizes[] = {std::ranges::size(columns)...};
+  std::size_t rows = sizes[0];
+  if (((std::ranges::size(columns) != rows) || ...))
+    throw std::invalid_argument("the columns of a batch differ in size");
+
+  detail::format_rows<fmt,
+                      std::ranges::range_reference_t<const Columns>...>(
+      out, offsets, rows, [&](std::size_t i, auto f) {
+        return f(std::ranges::begin(columns)[i]...);
+      });
+}
+
+} // namespace detail
+
+// A range of rows, every row is a tuple-like type with the arguments.
+template <class R>
+concept batch_rows =
+    std::ranges::random_access_range<const R> &&
+    std::ranges::sized_range<const R> &&
+    requires { std::tuple_size<std::ranges::range_value_t<R>>::value; };
+
+// A column with one argument of every row.
+template <class C>
+concept batch_column = std::ranges::random_access_range<const C> &&
+                       std::ranges::sized_range<const C>;
+
+// Appends the output of every row to out.
+//
+// The format string is parsed once for all rows. When the output of a row has
+// an upper limit the rows are written directly in the string, otherwise the
+// string is reserved for the literal text of all rows. When a formatter throws
+// out contains the rows before the failing row.
+template <fixed_string fmt, batch_rows R>
+  requires std::same_as<typename decltype(fmt)::char_type, char>
+void format_batch(std::string &out, const R &rows) {
+  detail::format_batch<fmt>(out, nullptr, rows);
+}
+
+// Appends the output of every row to out.text and its end to out.offsets.
+template <fixed_string fmt, batch_rows R>
+  requires std::same_as<typename decltype(fmt)::char_type, char>
+void format_batch(batch_output &out, const R &rows) {
+  detail::format_batch<fmt>(out.text, &out.offsets, rows);
+}
+
+// Appends the output of every row to out, the arguments of row i are element i
+// of the columns.
+//
+// Throws std::invalid_argument when the columns differ in size.
+template <fixed_string fmt, batch_column... Columns>
+  requires std::same_as<typename decltype(fmt)::char_type, char> &&
+           (sizeof...(Columns) > 0)
+void format_columns(std::string &out, const Columns &...columns) {
+  detail::format_columns<fmt>(out, nullptr, columns...);
+}
+
+// Appends the output of every row to out.text and its end to out.offsets.
+template <fixed_string fmt, batch_column... Columns>
+  requires std::same_as<typename decltype(fmt)::char_type, char> &&
+           (sizeof...(Columns) > 0)
+void format_columns(batch_output &out, const Columns &...columns) {
+  detail::format_columns<fmt>(out.text, &out.offsets, columns...);
+}
+
+} // namespace ctf
+
+#endif // CTF_BATCH_HPP
@@ -0,0 +1,177 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CTF_BATCH_PARALLEL_HPP
+#define CTF_BATCH_PARALLEL_HPP
+
+#include "batch.hpp"
+#include "utility.hpp"
+
+#include <algorithm>
+#include <concepts>
+#include <cstddef>
+#include <exception>
+#include <ranges>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace ctf {
+
+// The minimum number of rows formatted by one thread.
+//
+// Smaller batches use fewer threads, the cost of starting a thread exceeds
+// the cost of formatting a few rows.
+inline constexpr std::size_t parallel_batch_min_rows = 1024;
+
+namespace detail {
+
+// Splits rows in parts for at most threads threads, 0 uses a thread per core.
+//
+// Returns the first row of every part followed by rows.
+inline std::vector<std::size_t> batch_parts(std::size_t rows,
+                                            std::size_t threads) {
+  if (threads == 0)
+    threads = std::max(std::thread::hardware_concurrency(), 1u);
+  std::size_t parts =
+      std::clamp(rows / parallel_batch_min_rows, std::size_t(1), threads);
+
+  std::vector<std::size_t> result(parts + 1);
+  for (std::size_t i = 0; i <= parts; ++i)
+    result[i] = rows * i / parts;
+  return result;
+}
+
+// Calls work(i) for every part, part 0 on the calling thread.
+//
+// Rethrows the exception of the first failing part.
+template <class Work> void run_parts(std::size_t parts, Work work) {
+  std::vector<std::exception_ptr> errors(parts);
+  {
+    std::vector<std::jthread> threads;
+    threads.reserve(parts - 1);
+    for (std::size_t i = 1; i < parts; ++i)
+      threads.emplace_back([&, i] {
+        try {
+          work(i);
+        } catch (...) {
+          errors[i] = std::current_exception();
+        }
+      });
+
+    try {
+      work(0);
+    } catch (...) {
+      errors[0] = std::current_exception();
+    }
+  }
+
+  for (const std::exception_ptr &error : errors)
+    if (error)
+      std::rethrow_exception(error);
+}
+
+// Formats the parts of rows on separate threads.
+//
+// When offsets is not nullptr it receives the offsets of every part.
+template <fixed_string fmt, class R>
+std::vector<std::string>
+format_batch_parts(const R &rows, std::size_t threads,
+                   std::vector<std::vector<std::size_t>> *offsets) {
+  std::vector<std::size_t> parts =
+      detail::batch_parts(std::ranges::size(rows), threads);
+  std::vector<std::string> result(parts.size() - 1);
+  if (offsets)
+    offsets->resize(result.size());
+
+  auto first = std::ranges::begin(rows);
+  detail::run_parts(result.size(), [&](std::size_t i) {
+    detail::format_batch<fmt>(
+        result[i], offsets ? &(*offsets)[i] : nullptr,
+        std::ranges::subrange(first + parts[i], first + parts[i + 1]));
+  });
+  return result;
+}
+
+// Appends the parts to out.
+//
+// Returns the offset of every part in out. The parts are copied in parallel,
+// the memory of a part is released after its copy.
+inline std::vector<std::size_t> join_parts(std::string &out,
+                                           std::vector<std::string> &parts) {
+  std::vector<std::size_t> result(parts.size());
+  std::size_t size = out.size();
+  for (std::size_t i = 0; i != parts.size(); ++i) {
+    result[i] = size;
+    size += parts[i].size();
+  }
+
+  out.resize_and_overwrite(size, [&](char *data, std::size_t) noexcept {
+    auto copy = [&](std::size_t i) noexcept {
+      std::ranges::copy(parts[i], data + result[i]);
+      std::string{}.swap(parts[i]);
+    };
+    try {
+      detail::run_parts(parts.size(), copy);
+    } catch (...) {
+      // Creating a thread failed, copying again is harmless.
+      for (std::size_t i = 0; i != parts.size(); ++i)
+        copy(i);
+    }
+    return size;
+  });
+  return result;
+}
+
+} // namespace detail
+
+// Formats the rows on multiple threads, returning the output in order.
+//
+// Every thread formats a contiguous part of the rows in its own string. The
+// strings can be written with one writev call. threads is the maximum number
+// of threads used, 0 uses one thread per core.
+template <fixed_string fmt, batch_rows R>
+  requires std::same_as<typename decltype(fmt)::char_type, char>
+std::vector<std::string> format_batch_chunks(const R &rows,
+                                             std::size_t threads = 0) {
+  return detail::format_batch_parts<fmt>(rows, threads, nullptr);
+}
+
+// Appends the output of every row to out, formatting on multiple threads.
+//
+// The output is the same as the output of ctf::format_batch. After formatting
+// the parts are copied in place, using the prefix sum of their sizes. When a
+// formatter throws out is not modified.
+template <fixed_string fmt, batch_rows R>
+  requires std::same_as<typename decltype(fmt)::char_type, char>
+void format_batch_parallel(std::string &out, const R &rows,
+                           std::size_t threads = 0) {
+  std::vector<std::string> parts =
+      detail::format_batch_parts<fmt>(rows, threads, nullptr);
+  detail::join_parts(out, parts);
+}
+
+// Appends the output of every row to out.text and its end to out.offsets,
+// formatting on multiple threads.
+template <fixed_string fmt, batch_rows R>
+  requires std::same_as<typename decltype(fmt)::char_type, char>
+void format_batch_parallel(batch_output &out, const R &rows,
+                           std::size_t threads = 0) {
+  std::vector<std::vector<std::size_t>> offsets;
+  std::vector<std::string> parts =
+      detail::format_batch_parts<fmt>(rows, threads, &offsets);
+  std::vector<std::size_t> start = detail::join_parts(out.text, parts);
+
+  out.offsets.reserve(out.offsets.size() + std::ranges::size(rows));
+  for (std::size_t i = 0; i != offsets.size(); ++i)
+    for (std::size_t offset : offsets[i])
+      out.offsets.push_back(start[i] + offset);
+}
+
+} // namespace ctf
+
+#endif // CTF_BATCH_PARALLEL_HPP
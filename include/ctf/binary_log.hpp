@@ -0,0 +1,215 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CTF_BINARY_LOG_HPP
+#define CTF_BINARY_LOG_HPP
+
+#include "argument_encoding.hpp"
+#include "format.hpp"
+#include "sink.hpp"
+#include "utility.hpp"
+
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <map>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Binary capture of formatting calls.
+//
+// ctf::capture writes the id of the call site and the encoded arguments to a
+// binary_log, no text is formatted. The id is a hash of the format string and
+// the argument types. Every call site registers its decoder at start-up, so a
+// program containing the same call sites can render the log, see
+// ctf::decode_binary_log and the ctf-decode tool.
+//
+// The ids depend on the compiler used, the log needs to be decoded by a
+// program built with the same compiler.
+namespace ctf {
+
+namespace detail {
+
+inline constexpr std::uint64_t fnv_offset_basis = 14695981039346656037u;
+inline constexpr std::uint64_t fnv_prime = 1099511628211u;
+
+consteval std::uint64_t fnv1a(std::uint64_t hash, std::string_view data) {
+  for (char c : data) {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= fnv_prime;
+  }
+  return hash;
+}
+
+template <class T> consteval std::uint64_t type_hash(std::uint64_t hash) {
+  // The function name contains the name of T.
+  return fnv1a(hash, __PRETTY_FUNCTION__);
+}
+
+// The magic number at the start of a binary log.
+inline constexpr std::string_view binary_log_magic{"CTF-BIN1", 8};
+
+struct record_header {
+  std::uint64_t id;
+  std::uint64_t size;
+};
+
+// The decoders of the call sites in the program.
+inline std::map<std::uint64_t, record_decoder> &decoders() {
+  static std::map<std::uint64_t, record_decoder> result;
+  return result;
+}
+
+template <fixed_string fmt, class... Args>
+consteval std::uint64_t make_capture_id() {
+  std::uint64_t hash = fnv_offset_basis;
+  for (std::size_t i = 0; i != fmt.size(); ++i) {
+    hash ^= static_cast<unsigned char>(fmt[i]);
+    hash *= fnv_prime;
+  }
+  ((hash = type_hash<decoded_t<Args>>(hash)), ...);
+  return hash;
+}
+
+} // namespace detail
+
+// The id of the records of a call site.
+//
+// The arguments are hashed as their decoded_t, so a string literal and a
+// std::string using the same format string have the same id.
+template <fixed_string fmt, class... Args>
+inline constexpr std::uint64_t capture_id =
+    detail::make_capture_id<fmt, Args...>();
+
+namespace detail {
+
+template <fixed_string fmt, class... Args> struct capture_site {
+  static bool add() {
+    decoders().emplace(capture_id<fmt, Args...>,
+                       &decode_record<fmt, Args...>);
+    return true;
+  }
+
+  // Registers the decoder during the dynamic initialization of the program.
+  static inline const bool registered = add();
+};
+
+} // namespace detail
+
+// A buffered binary log written to a file descriptor.
+//
+// The log starts with a magic number, so fd needs to refer to an empty file.
+// The class is not thread-safe, use one log per thread.
+class binary_log {
+public:
+  // The size of the buffer, larger records grow the buffer.
+  static constexpr std::size_t buffer_size = 64 * 1024;
+
+  explicit binary_log(int fd) : fd_(fd), buffer_(buffer_size) {
+    std::memcpy(buffer_.data(), detail::binary_log_magic.data(),
+                detail::binary_log_magic.size());
+    size_ = detail::binary_log_magic.size();
+  }
+
+  ~binary_log() {
+    try {
+      flush();
+    } catch (...) {
+    }
+  }
+
+  binary_log(const binary_log &) = delete;
+  binary_log &operator=(const binary_log &) = delete;
+
+  // Adds a record with size bytes of arguments, written by encode.
+  template <class Encode>
+  void append(std::uint64_t id, std::size_t size, Encode encode) {
+    std::size_t required = sizeof(detail::record_header) + size;
+    if (buffer_.size() - size_ < required) [[unlikely]] {
+      flush();
+      if (buffer_.size() < required)
+        buffer_.resize(required);
+    }
+
+    detail::record_header header{id, size};
+    std::memcpy(&buffer_[size_], &header, sizeof(header));
+    encode(&buffer_[size_ + sizeof(header)]);
+    size_ += required;
+  }
+
+  void flush() {
+    std::size_t size = std::exchange(size_, 0);
+    detail::write_fd(
+        fd_, {reinterpret_cast<const char *>(buffer_.data()), size});
+  }
+
+private:
+  int fd_;
+  std::vector<std::byte> buffer_;
+  std::size_t size_;
+};
+
+// Writes the call site id and the arguments to log.
+template <fixed_string fmt, class... Args>
+  requires std::same_as<typename decltype(fmt)::char_type, char>
+void capture(binary_log &log, Args &&...args) {
+  constexpr auto status = parse<fmt, Args...>();
+
+  if constexpr (ctf::is_format_error(status))
+    static_assert(!"parse error", status);
+  else if constexpr (!(detail::capturable<std::remove_cvref_t<Args>> && ...))
+    static_assert(!"unsupported argument",
+                  "the arguments need to be strings, arithmetic types, "
+                  "enumerations, or void pointers");
+  else {
+    using site = detail::capture_site<fmt, std::remove_cvref_t<Args>...>;
+    (void)site::registered;
+
+    std::size_t size = (std::size_t(0) + ... + detail::encoded_size(args));
+    log.append(capture_id<fmt, std::remove_cvref_t<Args>...>, size,
+               [&](std::byte *data) { (detail::encode(data, args), ...); });
+  }
+}
+
+// Writes the formatted output of the records in data to out.
+//
+// Records of call sites that are not part of this program are written as a
+// line with their id. Throws std::runtime_error when data is not a valid
+// binary log, or an argument does not fit in its record.
+inline void decode_binary_log(std::span<const std::byte> data, fd_sink &out) {
+  if (data.size() < detail::binary_log_magic.size() ||
+      std::memcmp(data.data(), detail::binary_log_magic.data(),
+                  detail::binary_log_magic.size()) != 0)
+    throw std::runtime_error("the data is not a ctf binary log");
+  data = data.subspan(detail::binary_log_magic.size());
+
+  while (!data.empty()) {
+    detail::record_header header;
+    if (data.size() < sizeof(header))
+      throw std::runtime_error("truncated record header");
+    std::memcpy(&header, data.data(), sizeof(header));
+    data = data.subspan(sizeof(header));
+    if (data.size() < header.size)
+      throw std::runtime_error("truncated record");
+
+    auto decoder = detail::decoders().find(header.id);
+    if (decoder != detail::decoders().end())
+      decoder->second(data.data(), data.data() + header.size, out);
+    else
+      ctf::format_to<"<unknown record {:016x}>\n">(out, header.id);
+    data = data.subspan(header.size);
+  }
+}
+
+} // namespace ctf
+
+#endif // CTF_BINARY_LOG_HPP
@@ -0,0 +1,413 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CTF_BYTES_HPP
+#define CTF_BYTES_HPP
+
+// This uses libc++'s implementation details to write to the output buffer.
+#include <version>
+#ifndef _LIBCPP_VERSION
+#error This header requires libc++'s format implementation
+#endif
+
+#include "format_error.hpp"
+#include "formatter.hpp"
+#include "utility.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <span>
+#include <string_view>
+#include <utility>
+
+namespace ctf {
+
+// A sequence of bytes, formatted as hexadecimal digits, base64, or a hexdump.
+//
+// std::span<const unsigned char> is a range of integers, which has its own
+// std::formatter, so the bytes are formatted using this wrapper.
+struct bytes_view {
+  std::span<const unsigned char> data;
+};
+
+inline bytes_view bytes(std::span<const unsigned char> data) noexcept {
+  return {data};
+}
+
+inline bytes_view bytes(std::span<const std::byte> data) noexcept {
+  return {{reinterpret_cast<const unsigned char *>(data.data()), data.size()}};
+}
+
+// The display types of bytes.
+enum class bytes_type {
+  // {:x}, the default, lower case hexadecimal digits.
+  hex_lower,
+  // {:X}, upper case hexadecimal digits.
+  hex_upper,
+  // {:b}, base64 using the alphabet and padding of RFC 4648.
+  base64,
+  // {:h}, the layout of hexdump -C; 16 bytes per line with the offset and the
+  // printable characters.
+  hexdump
+};
+
+// The parsed format-spec of bytes.
+//
+// bytes-spec ::= [separator [group-size]] [type]
+// separator  ::= ' ' | ':' | '-' | '_' | ','
+//
+// The separator is written between groups of group-size bytes, the default
+// group-size is 1. It can only be used with hexadecimal digits.
+struct bytes_spec {
+  bytes_type type = bytes_type::hex_lower;
+  char separator = '\0';
+  std::uint32_t group = 1;
+};
+
+namespace detail {
+
+struct bytes_spec_result {
+  bytes_spec spec;
+  // The number of parsed characters.
+  std::size_t size = 0;
+  const char *error = nullptr;
+};
+
+// Parses the format-spec of bytes, s starts after the colon.
+constexpr bytes_spec_result parse_bytes_spec(std::string_view s) {
+  bytes_spec_result result;
+  std::size_t &i = result.size;
+  auto fail = [&](const char *error) {
+    result.error = error;
+    return result;
+  };
+
+  if (i != s.size() && std::string_view{" :-_,"}.contains(s[i]))
+    result.spec.separator = s[i++];
+
+  if (i != s.size() && s[i] >= '0' && s[i] <= '9') {
+    if (result.spec.separator == '\0')
+      return fail("a group-size requires a separator");
+    std::uint64_t group = 0;
+    for (; i != s.size() && s[i] >= '0' && s[i] <= '9'; ++i) {
+      group = group * 10 + (s[i] - '0');
+      if (group > 0xffff'ffff)
+        return fail("the group-size is too large");
+    }
+    if (group == 0)
+      return fail("the group-size needs to be at least 1");
+    result.spec.group = group;
+  }
+
+  if (i != s.size()) {
+    switch (s[i]) {
+    case 'x':
+      ++i;
+      break;
+    case 'X':
+      result.spec.type = bytes_type::hex_upper;
+      ++i;
+      break;
+    case 'b':
+      result.spec.type = bytes_type::base64;
+      ++i;
+      break;
+    case 'h':
+      result.spec.type = bytes_type::hexdump;
+      ++i;
+      break;
+    }
+  }
+
+  if (i == s.size())
+    return fail("unable to find the end of the format-spec");
+  if (s[i] != '}')
+    return fail("invalid format-spec for bytes");
+  if (result.spec.separator != '\0' &&
+      (result.spec.type == bytes_type::base64 ||
+       result.spec.type == bytes_type::hexdump))
+    return fail("a separator can only be used with hexadecimal digits");
+  return result;
+}
+
+// The number of characters written for n bytes.
+constexpr std::size_t bytes_size(const bytes_spec &spec, std::size_t n) {
+  switch (spec.type) {
+  case bytes_type::hex_lower:
+  case bytes_type::hex_upper:
+    return 2 * n +
+           (spec.separator != '\0' && n != 0 ? (n - 1) / spec.group : 0);
+  case bytes_type::base64:
+    return (n + 2) / 3 * 4;
+  case bytes_type::hexdump:
+    // A complete line is 79 characters, a partial line has fewer printable
+    // characters.
+    return n / 16 * 79 + (n % 16 != 0 ? 63 + n % 16 : 0);
+  }
+  std::unreachable();
+}
+
+using bytes_block = unsigned char __attribute__((vector_size(16)));
+using bytes_block_32 = std::uint32_t __attribute__((vector_size(16)));
+
+// The size of the buffer used to write the output.
+inline constexpr std::size_t bytes_buffer_size = 512;
+
+// The hexadecimal digit of every element, the elements are less than 16.
+template <bool upper> bytes_block hex_digits(bytes_block v) {
+  using U = unsigned char;
+  return v + U('0') + (bytes_block(v > U(9)) & U(upper ? 7 : 39));
+}
+
+// Encodes bytes as hexadecimal digits without separators.
+//
+// Every 16 bytes are converted at once, the digits of the high and low
+// nibbles are interleaved with a shuffle.
+template <bool upper, class Write>
+void encode_hex(std::span<const unsigned char> in, Write write) {
+  static constexpr char digits[] = {'0', '1', '2', '3', '4', '5', '6', '7',
+                                    '8', '9', upper ? 'A' : 'a',
+                                    upper ? 'B' : 'b', upper ? 'C' : 'c',
+                                    upper ? 'D' : 'd', upper ? 'E' : 'e',
+                                    upper ? 'F' : 'f'};
+  char buffer[bytes_buffer_size];
+  while (!in.empty()) {
+    std::size_t n = std::min(in.size(), bytes_buffer_size / 2);
+    char *out = buffer;
+    std::size_t i = 0;
+    for (; n - i >= 16; i += 16, out += 32) {
+      bytes_block v;
+      __builtin_memcpy(&v, in.data() + i, 16);
+      bytes_block high = detail::hex_digits<upper>(v >> 4);
+      bytes_block low = detail::hex_digits<upper>(v & 0xf);
+      auto r = __builtin_shufflevector(high, low, 0, 16, 1, 17, 2, 18, 3, 19,
+                                       4, 20, 5, 21, 6, 22, 7, 23, 8, 24, 9,
+                                       25, 10, 26, 11, 27, 12, 28, 13, 29, 14,
+                                       30, 15, 31);
+      __builtin_memcpy(out, &r, 32);
+    }
+    for (; i != n; ++i) {
+      *out++ = digits[in[i] >> 4];
+      *out++ = digits[in[i] & 0xf];
+    }
+    write(std::string_view{buffer, out});
+    in = in.subspan(n);
+  }
+}
+
+// Encodes bytes as hexadecimal digits with a separator between the groups.
+template <class Write>
+void encode_hex_grouped(std::span<const unsigned char> in,
+                        const bytes_spec &spec, Write write) {
+  const char *digits = spec.type == bytes_type::hex_upper ? "0123456789ABCDEF"
+                                                          : "0123456789abcdef";
+  char buffer[bytes_buffer_size];
+  char *out = buffer;
+  std::uint32_t group = 0;
+  for (std::size_t i = 0; i != in.size(); ++i) {
+    if (buffer + bytes_buffer_size - out < 3) {
+      write(std::string_view{buffer, out});
+      out = buffer;
+    }
+    if (group == spec.group) {
+      *out++ = spec.separator;
+      group = 0;
+    }
+    ++group;
+    *out++ = digits[in[i] >> 4];
+    *out++ = digits[in[i] & 0xf];
+  }
+  write(std::string_view{buffer, out});
+}
+
+// The base64 characters of every element, the elements are less than 64.
+//
+// The offset from the index to the character is selected by comparisons
+// instead of a table lookup.
+inline bytes_block base64_characters(bytes_block v) {
+  using U = unsigned char;
+  return v + U('A') + (bytes_block(v >= U(26)) & U('a' - 26 - 'A')) +
+         (bytes_block(v >= U(52)) & U('0' - 52 - ('a' - 26))) +
+         (bytes_block(v >= U(62)) & U('+' - 62 - ('0' - 52))) +
+         (bytes_block(v >= U(63)) & U('/' - 63 - ('+' - 62)));
+}
+
+// Encodes bytes as base64.
+//
+// Every 12 bytes are converted to 16 characters at once. A shuffle places
+// every 3 bytes in a 32-bit element, in which the four 6-bit indices are
+// extracted with shifts.
+template <class Write>
+void encode_base64(std::span<const unsigned char> in, Write write) {
+  static constexpr char alphabet[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  char buffer[bytes_buffer_size];
+  while (!in.empty()) {
+    // The input of a complete buffer is a multiple of 3 bytes, so only the
+    // last part needs padding.
+    std::size_t n = std::min(in.size(), bytes_buffer_size / 4 * 3);
+    char *out = buffer;
+    std::size_t i = 0;
+    if constexpr (std::endian::native == std::endian::little)
+      // The load reads 16 bytes and uses the first 12.
+      for (; n - i >= 16; i += 12, out += 16) {
+        bytes_block v;
+        __builtin_memcpy(&v, in.data() + i, 16);
+        // The 3 bytes a, b, c become the element c | b << 8 | a << 16.
+        bytes_block s = __builtin_shufflevector(
+            v, v, 2, 1, 0, 15, 5, 4, 3, 15, 8, 7, 6, 15, 11, 10, 9, 15);
+        bytes_block_32 t = bytes_block_32(s) & 0xff'ffff;
+        bytes_block_32 indices = ((t >> 18) & 0x3f) |
+                                 (((t >> 12) & 0x3f) << 8) |
+                                 (((t >> 6) & 0x3f) << 16) |
+                                 ((t & 0x3f) << 24);
+        bytes_block r = detail::base64_characters(bytes_block(indices));
+        __builtin_memcpy(out, &r, 16);
+      }
+    for (; n - i >= 3; i += 3) {
+      std::uint32_t t = in[i] << 16 | in[i + 1] << 8 | in[i + 2];
+      *out++ = alphabet[t >> 18];
+      *out++ = alphabet[(t >> 12) & 0x3f];
+      *out++ = alphabet[(t >> 6) & 0x3f];
+      *out++ = alphabet[t & 0x3f];
+    }
+    if (i != n) {
+      std::uint32_t t = in[i] << 16 | (n - i == 2 ? in[i + 1] << 8 : 0);
+      *out++ = alphabet[t >> 18];
+      *out++ = alphabet[(t >> 12) & 0x3f];
+      *out++ = n - i == 2 ? alphabet[(t >> 6) & 0x3f] : '=';
+      *out++ = '=';
+    }
+    write(std::string_view{buffer, out});
+    in = in.subspan(n);
+  }
+}
+
+// Encodes bytes in the layout of hexdump -C, without the final offset.
+//
+// 00000000  68 65 6c 6c 6f 2c 20 77  6f 72 6c 64 0a           |hello, world.|
+template <class Write>
+void encode_hexdump(std::span<const unsigned char> in, Write write) {
+  static constexpr char digits[] = "0123456789abcdef";
+  char buffer[bytes_buffer_size];
+  char *out = buffer;
+  for (std::size_t offset = 0; offset < in.size(); offset += 16) {
+    if (buffer + bytes_buffer_size - out < 79) {
+      write(std::string_view{buffer, out});
+      out = buffer;
+    }
+    for (int shift = 28; shift >= 0; shift -= 4)
+      *out++ = digits[(offset >> shift) & 0xf];
+    *out++ = ' ';
+
+    std::size_t n = std::min<std::size_t>(in.size() - offset, 16);
+    for (std::size_t i = 0; i != 16; ++i) {
+      if (i % 8 == 0)
+        *out++ = ' ';
+      if (i < n) {
+        *out++ = digits[in[offset + i] >> 4];
+        *out++ = digits[in[offset + i] & 0xf];
+      } else {
+        *out++ = ' ';
+        *out++ = ' ';
+      }
+      *out++ = ' ';
+    }
+
+    *out++ = ' ';
+    *out++ = '|';
+    for (std::size_t i = 0; i != n; ++i) {
+      unsigned char c = in[offset + i];
+      *out++ = c >= 0x20 && c < 0x7f ? c : '.';
+    }
+    *out++ = '|';
+    *out++ = '\n';
+  }
+  write(std::string_view{buffer, out});
+}
+
+// Writes a block of output to the iterator.
+template <class OutIt> void write_block(OutIt &out, std::string_view s) {
+  if constexpr (requires { out.write(std::span<const char>{s}); })
+    out.write(std::span<const char>{s});
+  else
+    out = std::__formatter::__copy(s, std::move(out));
+}
+
+} // namespace detail
+
+// Parses the format-spec of bytes at compile-time.
+template <fixed_string fmt, std::size_t begin, arg_id_status arg_id,
+          class... Args>
+  requires std::same_as<char, typename decltype(fmt)::char_type>
+struct formatter<bytes_view, fmt, begin, arg_id, Args...> {
+  static consteval auto create() {
+    constexpr auto result = detail::parse_bytes_spec(
+        std::string_view{&fmt[begin], &fmt[fmt.size()]});
+    if constexpr (result.error != nullptr)
+      return ctf::create_format_error(result.error, fmt, begin,
+                                      begin + result.size,
+                                      begin + result.size);
+    else
+      return formatter_result<begin + result.size, arg_id,
+                              std::formatter<bytes_view, char>>{
+          {result.spec}};
+  }
+};
+
+} // namespace ctf
+
+template <> struct std::formatter<ctf::bytes_view, char> {
+  ctf::bytes_spec spec;
+
+  constexpr typename std::format_parse_context::iterator
+  parse(std::format_parse_context &ctx) {
+    auto result = ctf::detail::parse_bytes_spec({ctx.begin(), ctx.end()});
+    if (result.error != nullptr)
+      throw std::format_error(result.error);
+    spec = result.spec;
+    return ctx.begin() + result.size;
+  }
+
+  // The size of the output is known before encoding, so a sink reserves it
+  // once.
+  template <class FormatContext>
+  typename FormatContext::iterator format(ctf::bytes_view value,
+                                          FormatContext &ctx) const {
+    auto out = ctx.out();
+    if constexpr (requires { out.reserve(std::size_t(0)); })
+      out.reserve(ctf::detail::bytes_size(spec, value.data.size()));
+
+    auto write = [&](std::string_view s) {
+      ctf::detail::write_block(out, s);
+    };
+    switch (spec.type) {
+    case ctf::bytes_type::hex_lower:
+    case ctf::bytes_type::hex_upper:
+      if (spec.separator != '\0')
+        ctf::detail::encode_hex_grouped(value.data, spec, write);
+      else if (spec.type == ctf::bytes_type::hex_upper)
+        ctf::detail::encode_hex<true>(value.data, write);
+      else
+        ctf::detail::encode_hex<false>(value.data, write);
+      break;
+    case ctf::bytes_type::base64:
+      ctf::detail::encode_base64(value.data, write);
+      break;
+    case ctf::bytes_type::hexdump:
+      ctf::detail::encode_hexdump(value.data, write);
+      break;
+    }
+    return out;
+  }
+};
+
+#endif // CTF_BYTES_HPP
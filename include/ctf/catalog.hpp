@@ -0,0 +1,119 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CTF_CATALOG_HPP
+#define CTF_CATALOG_HPP
+
+#include "format.hpp"
+#include "sink.hpp"
+#include "utility.hpp"
+
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace ctf {
+
+namespace detail {
+
+// Reports the parse error of the format string, if any.
+template <fixed_string fmt, class... Args> consteval void catalog_check() {
+  constexpr auto status = parse<fmt, Args...>();
+
+  if constexpr (ctf::is_format_error(status))
+    static_assert(!"parse error", status);
+}
+
+template <fixed_string fmt, class S, class... Args>
+void catalog_format_to(S &sink, Args &...args) {
+  ctf::format_to<fmt>(sink, args...);
+}
+
+template <fixed_string fmt, class... Args>
+std::basic_string<typename decltype(fmt)::char_type>
+catalog_format(Args &...args) {
+  return ctf::format<fmt>(args...);
+}
+
+} // namespace detail
+
+// A message with a format string for every language.
+//
+// Every format string is validated against the same argument types, the
+// translations may use the arguments in a different order by using arg-ids.
+// The language is selected at run-time by its index, which selects the
+// function formatting the tokens of that format string.
+template <fixed_string fmt, fixed_string... fmts>
+  requires(std::same_as<typename decltype(fmt)::char_type,
+                        typename decltype(fmts)::char_type> &&
+           ...)
+class catalog {
+public:
+  using char_type = typename decltype(fmt)::char_type;
+
+  // The number of languages.
+  static constexpr std::size_t size = 1 + sizeof...(fmts);
+
+  // Whether every format string is valid for the arguments.
+  template <class... Args>
+  static constexpr bool valid =
+      ctf::valid<fmt, Args...> && (ctf::valid<fmts, Args...> && ...);
+
+  // Writes the output of the format string of language to the sink.
+  //
+  // Throws std::out_of_range when language is not less than size.
+  template <class S, class... Args>
+    requires sink<S, char_type>
+  static void format_to(S &sink, std::size_t language, Args &&...args) {
+    if constexpr (!valid<Args...>) {
+      detail::catalog_check<fmt, Args...>();
+      (detail::catalog_check<fmts, Args...>(), ...);
+    } else {
+      static constexpr std::array<
+          void (*)(S &, std::remove_reference_t<Args> &...), size>
+          formatters{&detail::catalog_format_to<
+                         fmt, S, std::remove_reference_t<Args>...>,
+                     &detail::catalog_format_to<
+                         fmts, S, std::remove_reference_t<Args>...>...};
+
+      if (language >= size)
+        throw std::out_of_range("the language is not in the catalog");
+      formatters[language](sink, args...);
+    }
+  }
+
+  // Returns the output of the format string of language.
+  //
+  // Throws std::out_of_range when language is not less than size.
+  template <class... Args>
+  static std::basic_string<char_type> format(std::size_t language,
+                                             Args &&...args) {
+    if constexpr (!valid<Args...>) {
+      detail::catalog_check<fmt, Args...>();
+      (detail::catalog_check<fmts, Args...>(), ...);
+    } else {
+      static constexpr std::array<std::basic_string<char_type> (*)(
+                                      std::remove_reference_t<Args> &...),
+                                  size>
+          formatters{
+              &detail::catalog_format<fmt, std::remove_reference_t<Args>...>,
+              &detail::catalog_format<fmts,
+                                      std::remove_reference_t<Args>...>...};
+
+      if (language >= size)
+        throw std::out_of_range("the language is not in the catalog");
+      return formatters[language](args...);
+    }
+  }
+};
+
+} // namespace ctf
+
+#endif // CTF_CATALOG_HPP
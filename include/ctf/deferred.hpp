@@ -0,0 +1,379 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CTF_DEFERRED_HPP
+#define CTF_DEFERRED_HPP
+
+#include "argument_encoding.hpp"
+#include "format.hpp"
+#include "sink.hpp"
+#include "utility.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <concepts>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+// Formatting on a background thread.
+//
+// ctf::deferred::log captures its arguments in a binary record in a queue of
+// the calling thread. A worker thread formats the records and writes the
+// output to a file descriptor. This moves the cost of formatting and writing
+// away from the calling thread.
+//
+// String arguments are copied, the other arguments need to be trivially
+// copyable and are copied with memcpy.
+namespace ctf::deferred {
+
+// What log does when the queue of the thread is full.
+enum class backpressure {
+  // Wait until the worker has made room.
+  block,
+  // Discard the record, the number of discarded records is returned by
+  // dropped.
+  drop
+};
+
+struct configuration {
+  // The file descriptor the output is written to.
+  int fd = STDERR_FILENO;
+  // The size of the queue of every thread, rounded up to a power of 2. The
+  // maximum size of one record is half the size of the queue, larger records
+  // are discarded.
+  std::size_t queue_size = 64 * 1024;
+  backpressure policy = backpressure::block;
+};
+
+namespace detail {
+
+// Wakes the worker when it waits for records.
+inline void notify_worker();
+
+// A single producer, single consumer queue of records.
+//
+// A record is a header followed by the encoded arguments. Records are stored
+// contiguously, when a record does not fit at the end of the buffer a header
+// without decoder marks the remainder of the buffer as padding.
+class queue {
+public:
+  struct header {
+    ctf::detail::record_decoder decode;
+    std::uint64_t size;
+  };
+
+  queue(std::size_t size, backpressure policy)
+      : capacity_(std::bit_ceil(std::max(size, 4 * sizeof(header)))),
+        policy_(policy), data_(std::make_unique<std::byte[]>(capacity_)) {}
+
+  // Adds a record with size bytes of arguments, written by encode.
+  //
+  // Returns whether the record is added.
+  template <class Encode>
+  bool push(ctf::detail::record_decoder decode, std::size_t size,
+            Encode encode) {
+    std::size_t required = sizeof(header) + round_up(size);
+    if (required > capacity_ / 2) [[unlikely]] {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    }
+
+    std::size_t tail = tail_.load(std::memory_order_relaxed);
+    std::size_t index = tail & (capacity_ - 1);
+    std::size_t padding = capacity_ - index < required ? capacity_ - index : 0;
+    while (tail + padding + required -
+               head_.load(std::memory_order_acquire) >
+           capacity_) {
+      if (policy_ == backpressure::drop) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+      }
+      std::this_thread::yield();
+    }
+
+    if (padding) {
+      write_header({nullptr, 0}, index);
+      index = 0;
+    }
+    write_header({decode, size}, index);
+    encode(&data_[index + sizeof(header)]);
+    tail_.store(tail + padding + required, std::memory_order_release);
+
+    // Pairs with the fence in drain, either the worker sees the record or the
+    // queue was empty and the worker may be waiting.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (head_.load(std::memory_order_relaxed) == tail)
+      notify_worker();
+    return true;
+  }
+
+  // Formats all records in the queue.
+  //
+  // Returns whether the queue contained records.
+  bool drain(fd_sink &out) {
+    std::size_t head = head_.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    std::size_t tail = tail_.load(std::memory_order_acquire);
+    if (head == tail)
+      return false;
+
+    while (head != tail) {
+      std::size_t index = head & (capacity_ - 1);
+      header h;
+      std::memcpy(&h, &data_[index], sizeof(header));
+      if (h.decode == nullptr) {
+        head += capacity_ - index;
+        continue;
+      }
+
+      try {
+        const std::byte *record = &data_[index + sizeof(header)];
+        h.decode(record, record + h.size, out);
+      } catch (...) {
+        // The output is lost, but the queue remains usable.
+      }
+      head += sizeof(header) + round_up(h.size);
+      head_.store(head, std::memory_order_release);
+    }
+    head_.store(head, std::memory_order_release);
+    return true;
+  }
+
+  bool empty() const noexcept {
+    return head_.load(std::memory_order_relaxed) ==
+           tail_.load(std::memory_order_acquire);
+  }
+
+  // Marks the queue as no longer used by its producer.
+  void close() noexcept { closed_.store(true, std::memory_order_release); }
+  bool closed() const noexcept {
+    return closed_.load(std::memory_order_acquire);
+  }
+
+  std::size_t dropped() const noexcept {
+    return dropped_.load(std::memory_order_relaxed);
+  }
+
+private:
+  static constexpr std::size_t round_up(std::size_t size) noexcept {
+    return (size + sizeof(header) - 1) / sizeof(header) * sizeof(header);
+  }
+
+  void write_header(header h, std::size_t index) noexcept {
+    std::memcpy(&data_[index], &h, sizeof(header));
+  }
+
+  std::size_t capacity_;
+  backpressure policy_;
+  std::unique_ptr<std::byte[]> data_;
+
+  // The producer and consumer positions, these only increase.
+  alignas(64) std::atomic<std::size_t> tail_{0};
+  alignas(64) std::atomic<std::size_t> head_{0};
+
+  std::atomic<std::size_t> dropped_{0};
+  std::atomic<bool> closed_{false};
+};
+
+inline configuration &settings() {
+  static configuration result;
+  return result;
+}
+
+inline std::atomic<bool> &started() {
+  static std::atomic<bool> result{false};
+  return result;
+}
+
+// The worker thread and the queues of all threads.
+class backend {
+public:
+  static backend &instance() {
+    static backend result;
+    return result;
+  }
+
+  ~backend() {
+    {
+      std::lock_guard lock{mutex_};
+      stop_ = true;
+    }
+    wakeup_.notify_one();
+    worker_.join();
+  }
+
+  std::shared_ptr<queue> create_queue() {
+    auto result =
+        std::make_shared<queue>(settings().queue_size, settings().policy);
+    std::lock_guard lock{mutex_};
+    queues_.push_back(result);
+    return result;
+  }
+
+  // Waits until all records added before the call are written.
+  void flush() {
+    std::unique_lock lock{mutex_};
+    std::uint64_t request = ++flush_requested_;
+    wakeup_.notify_one();
+    flushed_.wait(lock, [&] { return flush_completed_ >= request; });
+  }
+
+  // Wakes the worker after a record is added to an empty queue.
+  void notify() {
+    if (pending_.load(std::memory_order_relaxed))
+      return;
+    {
+      std::lock_guard lock{mutex_};
+      pending_.store(true, std::memory_order_relaxed);
+    }
+    wakeup_.notify_one();
+  }
+
+  std::size_t dropped() {
+    std::lock_guard lock{mutex_};
+    std::size_t result = dropped_;
+    for (const auto &q : queues_)
+      result += q->dropped();
+    return result;
+  }
+
+private:
+  backend() : out_(settings().fd) {
+    started() = true;
+    worker_ = std::thread{[this] { run(); }};
+  }
+
+  void run() {
+    std::unique_lock lock{mutex_};
+    while (true) {
+      std::uint64_t request = flush_requested_;
+      bool stop = stop_;
+      // Records added after this point are drained in this pass or notify
+      // the worker again.
+      pending_.store(false, std::memory_order_relaxed);
+      std::vector<std::shared_ptr<queue>> queues = queues_;
+      lock.unlock();
+
+      bool idle = true;
+      for (const auto &q : queues)
+        if (q->drain(out_))
+          idle = false;
+      try {
+        out_.flush();
+      } catch (...) {
+      }
+
+      lock.lock();
+      std::erase_if(queues_, [&](const auto &q) {
+        if (!q->closed() || !q->empty())
+          return false;
+        dropped_ += q->dropped();
+        return true;
+      });
+      flush_completed_ = request;
+      flushed_.notify_all();
+
+      if (stop)
+        return;
+      if (idle)
+        wakeup_.wait(lock, [&] {
+          return pending_.load(std::memory_order_relaxed) ||
+                 request != flush_requested_ || stop_;
+        });
+    }
+  }
+
+  fd_sink out_;
+
+  std::mutex mutex_;
+  std::condition_variable wakeup_;
+  std::condition_variable flushed_;
+  std::vector<std::shared_ptr<queue>> queues_;
+  std::size_t dropped_{0};
+  std::uint64_t flush_requested_{0};
+  std::uint64_t flush_completed_{0};
+  bool stop_{false};
+  // Whether a record is added to an empty queue since the last pass.
+  std::atomic<bool> pending_{false};
+
+  std::thread worker_;
+};
+
+inline void notify_worker() { backend::instance().notify(); }
+
+// The queue of the calling thread.
+inline queue &thread_queue() {
+  struct handle {
+    ~handle() {
+      if (q)
+        q->close();
+    }
+    std::shared_ptr<queue> q;
+  };
+  thread_local handle h;
+  if (!h.q) [[unlikely]]
+    h.q = backend::instance().create_queue();
+  return *h.q;
+}
+
+} // namespace detail
+
+// Sets the configuration of the worker.
+//
+// This needs to be called before the first call to log.
+inline void configure(const configuration &config) {
+  if (detail::started())
+    throw std::logic_error(
+        "ctf::deferred::configure called after the worker started");
+  detail::settings() = config;
+}
+
+// Adds the arguments to the queue of the calling thread, the output is
+// formatted and written by the worker.
+//
+// Returns false when the record is discarded.
+template <fixed_string fmt, class... Args>
+  requires std::same_as<typename decltype(fmt)::char_type, char>
+bool log(Args &&...args) {
+  constexpr auto status = parse<fmt, Args...>();
+
+  if constexpr (ctf::is_format_error(status))
+    static_assert(!"parse error", status);
+  else if constexpr (!(ctf::detail::capturable<std::remove_cvref_t<Args>> &&
+                       ...))
+    static_assert(!"unsupported argument",
+                  "the arguments need to be strings, arithmetic types, "
+                  "enumerations, or void pointers");
+  else {
+    std::size_t size =
+        (std::size_t(0) + ... + ctf::detail::encoded_size(args));
+    return detail::thread_queue().push(
+        &ctf::detail::decode_record<fmt, std::remove_cvref_t<Args>...>, size,
+        [&](std::byte *data) { (ctf::detail::encode(data, args), ...); });
+  }
+}
+
+// Waits until the output of all records added before the call is written.
+inline void flush() { detail::backend::instance().flush(); }
+
+// Returns the number of discarded records.
+inline std::size_t dropped() { return detail::backend::instance().dropped(); }
+
+} // namespace ctf::deferred
+
+#endif // CTF_DEFERRED_HPP
@@ -0,0 +1,202 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CTF_ESCAPE_HPP
+#define CTF_ESCAPE_HPP
+
+// This uses libc++'s implementation details to write to the output buffer.
+#include <version>
+#ifndef _LIBCPP_VERSION
+#error This header requires libc++'s format implementation
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace ctf {
+
+// The escaping display types of strings.
+enum class escape_kind {
+  none,
+  // {:j}, the contents of a JSON string.
+  json,
+  // {:h}, HTML text or an attribute value.
+  html,
+  // {:u}, percent-encoding of everything except the unreserved characters
+  // of RFC 3986.
+  url
+};
+
+namespace detail {
+
+// The number of code units classified at once.
+#ifdef __AVX2__
+inline constexpr std::size_t escape_block_size = 32;
+#else
+inline constexpr std::size_t escape_block_size = 16;
+#endif
+
+using escape_block =
+    unsigned char __attribute__((vector_size(escape_block_size)));
+
+template <escape_kind kind> constexpr bool needs_escape(unsigned char c) {
+  if constexpr (kind == escape_kind::json)
+    return c < 0x20 || c == '"' || c == '\\';
+  else if constexpr (kind == escape_kind::html)
+    return c == '&' || c == '<' || c == '>' || c == '"' || c == '\'';
+  else
+    return !((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+             (c >= '0' && c <= '9') || c == '-' || c == '.' || c == '_' ||
+             c == '~');
+}
+
+// The vector version of needs_escape, an element is non-zero when the code
+// unit needs escaping.
+template <escape_kind kind> escape_block escape_mask(escape_block v) {
+  using U = unsigned char;
+  if constexpr (kind == escape_kind::json)
+    return escape_block(v < U(0x20)) | escape_block(v == U('"')) |
+           escape_block(v == U('\\'));
+  else if constexpr (kind == escape_kind::html)
+    return escape_block(v == U('&')) | escape_block(v == U('<')) |
+           escape_block(v == U('>')) | escape_block(v == U('"')) |
+           escape_block(v == U('\''));
+  else {
+    // Subtracting the lower bound makes every range one unsigned compare.
+    escape_block unreserved = escape_block(v - U('a') <= U('z' - 'a')) |
+                              escape_block(v - U('A') <= U('Z' - 'A')) |
+                              escape_block(v - U('0') <= U('9' - '0')) |
+                              escape_block(v == U('-')) |
+                              escape_block(v == U('.')) |
+                              escape_block(v == U('_')) |
+                              escape_block(v == U('~'));
+    return ~unreserved;
+  }
+}
+
+// Returns the number of code units at the start of s that need no escaping.
+//
+// Complete blocks are classified without branches, only the block containing
+// the first code unit to escape is searched element by element.
+template <escape_kind kind>
+std::size_t escape_clean_prefix(std::string_view s) {
+  std::size_t i = 0;
+  for (; s.size() - i >= escape_block_size; i += escape_block_size) {
+    escape_block v;
+    __builtin_memcpy(&v, s.data() + i, escape_block_size);
+    escape_block mask = detail::escape_mask<kind>(v);
+
+    std::uint64_t words[escape_block_size / 8];
+    __builtin_memcpy(words, &mask, escape_block_size);
+    std::uint64_t any = 0;
+    for (std::uint64_t word : words)
+      any |= word;
+    if (any)
+      break;
+  }
+
+  while (i != s.size() && !detail::needs_escape<kind>(s[i]))
+    ++i;
+  return i;
+}
+
+// Returns the escape sequence of c, using buffer for generated sequences.
+template <escape_kind kind>
+std::string_view escape_sequence(unsigned char c, char (&buffer)[6]) {
+  static constexpr char hex_lower[] = "0123456789abcdef";
+  static constexpr char hex_upper[] = "0123456789ABCDEF";
+  if constexpr (kind == escape_kind::json) {
+    switch (c) {
+    case '"':
+      return "\\\"";
+    case '\\':
+      return "\\\\";
+    case '\n':
+      return "\\n";
+    case '\r':
+      return "\\r";
+    case '\t':
+      return "\\t";
+    }
+    buffer[0] = '\\';
+    buffer[1] = 'u';
+    buffer[2] = '0';
+    buffer[3] = '0';
+    buffer[4] = hex_lower[c >> 4];
+    buffer[5] = hex_lower[c & 0xf];
+    return {buffer, 6};
+  } else if constexpr (kind == escape_kind::html) {
+    switch (c) {
+    case '&':
+      return "&amp;";
+    case '<':
+      return "&lt;";
+    case '>':
+      return "&gt;";
+    case '"':
+      return "&quot;";
+    }
+    return "&#39;";
+  } else {
+    buffer[0] = '%';
+    buffer[1] = hex_upper[c >> 4];
+    buffer[2] = hex_upper[c & 0xf];
+    return {buffer, 3};
+  }
+}
+
+// Escapes s, calling write with the blocks of the output.
+//
+// The text without escapes is written as one block.
+template <escape_kind kind, class Write>
+void escape(std::string_view s, Write write) {
+  char buffer[6];
+  while (true) {
+    std::size_t n = detail::escape_clean_prefix<kind>(s);
+    if (n != 0)
+      write(s.substr(0, n));
+    if (n == s.size())
+      return;
+    write(detail::escape_sequence<kind>(s[n], buffer));
+    s.remove_prefix(n + 1);
+  }
+}
+
+} // namespace detail
+
+// The formatter for a string with an escaping display type.
+//
+// The escaped output is written directly to the output, unless a width is
+// used. Then the padding is based on the escaped string.
+template <escape_kind kind> struct escape_formatter {
+  std::formatter<std::string_view, char> formatter;
+
+  template <class FormatContext>
+  typename FormatContext::iterator format(std::string_view value,
+                                          FormatContext &ctx) const {
+    const auto &parser = formatter.__parser_;
+    if (parser.__width_as_arg_ || parser.__width_ != 0) {
+      std::string escaped;
+      detail::escape<kind>(value, [&](std::string_view s) { escaped += s; });
+      return formatter.format(escaped, ctx);
+    }
+
+    auto out = ctx.out();
+    detail::escape<kind>(value, [&](std::string_view s) {
+      out = std::__formatter::__copy(s, std::move(out));
+    });
+    return out;
+  }
+};
+
+} // namespace ctf
+
+#endif // CTF_ESCAPE_HPP
@@ -0,0 +1,274 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CTF_FIXED_HPP
+#define CTF_FIXED_HPP
+
+// This uses libc++'s implementation details to parse the format-spec and write
+// the padding.
+#include <version>
+#ifndef _LIBCPP_VERSION
+#error This header requires libc++'s format implementation
+#endif
+
+#include "format_error.hpp"
+#include "formatter.hpp"
+#include "formatter_string.hpp"
+#include "max_size.hpp"
+#include "utility.hpp"
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <iterator>
+#include <span>
+#include <string_view>
+
+namespace ctf {
+
+// An integer scaled by 10^N, like an amount in cents for N = 2.
+//
+// It is formatted as a decimal number with exactly N digits in the fraction,
+// without converting it to a floating-point value.
+template <std::size_t N> struct fixed_point {
+  static_assert(N <= 18, "the scale of a std::int64_t is at most 10^18");
+  std::int64_t value;
+};
+
+template <std::size_t N>
+constexpr fixed_point<N> fixed(std::int64_t value) noexcept {
+  return {value};
+}
+
+namespace detail {
+
+// The options of the std-format-spec used for fixed-point values.
+//
+// fixed-spec ::= [[fill]align][sign]['0'][width][grouping]
+// grouping   ::= ',' | '_'
+inline constexpr std::__format_spec::__fields fields_fixed = [] {
+  std::__format_spec::__fields result = std::__format_spec::__fields_integral;
+  result.__alternate_form_ = false;
+  result.__locale_specific_form_ = false;
+  result.__type_ = false;
+  result.__consume_all_ = false;
+  return result;
+}();
+
+// The size of the buffer for the output without padding.
+//
+// A sign, 19 digits and their 6 grouping separators, and the decimal point.
+inline constexpr std::size_t fixed_buffer_size = 27;
+
+inline constexpr auto decimal_digit_pairs = [] {
+  std::array<char, 200> result;
+  for (std::size_t i = 0; i != 100; ++i) {
+    result[2 * i] = '0' + i / 10;
+    result[2 * i + 1] = '0' + i % 10;
+  }
+  return result;
+}();
+
+// Writes exactly count digits of value backwards from last.
+//
+// Returns the position of the first digit.
+constexpr char *write_fixed_digits(char *last, std::uint64_t value,
+                                   std::size_t count) {
+  for (; count >= 2; count -= 2) {
+    last -= 2;
+    std::copy_n(&decimal_digit_pairs[2 * (value % 100)], 2, last);
+    value /= 100;
+  }
+  if (count)
+    *--last = '0' + value % 10;
+  return last;
+}
+
+// Writes the digits of value backwards from last.
+constexpr char *write_digits(char *last, std::uint64_t value) {
+  while (value >= 100) {
+    last = detail::write_fixed_digits(last, value % 100, 2);
+    value /= 100;
+  }
+  if (value >= 10)
+    return detail::write_fixed_digits(last, value, 2);
+  return detail::write_fixed_digits(last, value, 1);
+}
+
+inline constexpr std::uint64_t powers_of_10[] = {1,
+                                                 10,
+                                                 100,
+                                                 1'000,
+                                                 10'000,
+                                                 100'000,
+                                                 1'000'000,
+                                                 10'000'000,
+                                                 100'000'000,
+                                                 1'000'000'000,
+                                                 10'000'000'000,
+                                                 100'000'000'000,
+                                                 1'000'000'000'000,
+                                                 10'000'000'000'000,
+                                                 100'000'000'000'000,
+                                                 1'000'000'000'000'000,
+                                                 10'000'000'000'000'000,
+                                                 100'000'000'000'000'000,
+                                                 1'000'000'000'000'000'000};
+
+// Writes value scaled by 10^N backwards from last.
+//
+// The magnitude is split in the integer part and the fraction by one
+// division, both are written with the two-digit table.
+template <std::size_t N>
+constexpr char *write_fixed(char *last, std::int64_t value,
+                            std::__format_spec::__sign sign, char grouping) {
+  std::uint64_t magnitude =
+      value < 0 ? -std::uint64_t(value) : std::uint64_t(value);
+  std::uint64_t integer = magnitude / powers_of_10[N];
+  if constexpr (N != 0) {
+    last = detail::write_fixed_digits(last, magnitude % powers_of_10[N], N);
+    *--last = '.';
+  }
+
+  if (grouping != '\0')
+    for (; integer >= 1000; integer /= 1000) {
+      last = detail::write_fixed_digits(last, integer % 1000, 3);
+      *--last = grouping;
+    }
+  last = detail::write_digits(last, integer);
+
+  if (value < 0)
+    *--last = '-';
+  else if (sign == std::__format_spec::__sign::__plus)
+    *--last = '+';
+  else if (sign == std::__format_spec::__sign::__space)
+    *--last = ' ';
+  return last;
+}
+
+// Writes the number in [first, last) with the padding of the format-spec.
+//
+// Without padding the number is written as one block.
+template <class FormatContext>
+typename FormatContext::iterator
+write_number(char *first, char *last,
+             const std::__format_spec::__parser<char> &parser,
+             FormatContext &ctx) {
+  auto out = ctx.out();
+  if (!parser.__width_as_arg_ && parser.__width_ <= last - first) {
+    if constexpr (requires { out.write(std::span<const char>{}); })
+      out.write(std::span<const char>{first, last});
+    else
+      out = std::__formatter::__copy(std::string_view{first, last},
+                                     std::move(out));
+    return out;
+  }
+
+  // Like other numbers the value is right aligned by default.
+  auto specs = parser.__get_parsed_std_specifications(ctx);
+  if (specs.__alignment_ == std::__format_spec::__alignment::__default)
+    specs.__alignment_ = std::__format_spec::__alignment::__right;
+  else if (specs.__alignment_ ==
+           std::__format_spec::__alignment::__zero_padding) {
+    // The sign is written before the zeros.
+    if (*first == '-' || *first == '+' || *first == ' ') {
+      *out++ = *first++;
+      --specs.__width_;
+    }
+    specs.__alignment_ = std::__format_spec::__alignment::__right;
+    specs.__fill_.__data[0] = '0';
+  }
+  return std::__formatter::__write(first, last, std::move(out), specs);
+}
+
+template <std::size_t o, char g> struct fixed_grouping_result {
+  static constexpr std::size_t offset = o;
+  static constexpr char grouping = g;
+};
+
+template <fixed_string fmt, std::size_t begin, parse_status status>
+consteval auto parse_fixed_grouping() {
+  constexpr auto c = fmt[status.offset];
+  constexpr char grouping = c == ',' || c == '_' ? c : '\0';
+  constexpr std::size_t offset = status.offset + (grouping != '\0');
+
+  if constexpr (offset != fmt.size() && fmt[offset] != '}')
+    return create_format_error(
+        "unexpected character at the end of the format specification", fmt,
+        begin, offset, offset);
+  else
+    return fixed_grouping_result<offset, grouping>{};
+}
+
+} // namespace detail
+
+// Parses the format-spec of a fixed-point value at compile-time.
+template <std::size_t N, fixed_string fmt, std::size_t begin,
+          arg_id_status arg_id, class... Args>
+  requires std::same_as<char, typename decltype(fmt)::char_type>
+struct formatter<fixed_point<N>, fmt, begin, arg_id, Args...> {
+  static consteval auto create() {
+    using initial = detail::parse_status<begin, arg_id,
+                                         std::__format_spec::__parser<char>{}>;
+    auto status =
+        detail::parse<fmt, begin, detail::fields_fixed, initial{}, Args...>();
+
+    if constexpr (ctf::is_format_error(status))
+      return status;
+    else {
+      auto grouping = detail::parse_fixed_grouping<fmt, begin, status>();
+      if constexpr (ctf::is_format_error(grouping))
+        return grouping;
+      else {
+        using F = std::formatter<fixed_point<N>, char>;
+        return formatter_result<grouping.offset, status.arg_id, F>{
+            F{status.parser, grouping.grouping}};
+      }
+    }
+  }
+};
+
+} // namespace ctf
+
+template <std::size_t N> struct std::formatter<ctf::fixed_point<N>, char> {
+  std::__format_spec::__parser<char> parser;
+  // The separator between groups of three digits in the integer part.
+  char grouping = '\0';
+
+  constexpr typename std::format_parse_context::iterator
+  parse(std::format_parse_context &ctx) {
+    auto it = parser.__parse(ctx, ctf::detail::fields_fixed);
+    if (it != ctx.end() && (*it == ',' || *it == '_'))
+      grouping = *it++;
+    if (it != ctx.end() && *it != '}')
+      throw std::format_error(
+          "unexpected character at the end of the format specification");
+    return it;
+  }
+
+  template <class FormatContext>
+  typename FormatContext::iterator format(ctf::fixed_point<N> value,
+                                          FormatContext &ctx) const {
+    char buffer[ctf::detail::fixed_buffer_size + N];
+    char *last = std::end(buffer);
+    char *first = ctf::detail::write_fixed<N>(last, value.value,
+                                              parser.__sign_, grouping);
+
+    return ctf::detail::write_number(first, last, parser, ctx);
+  }
+
+  // The output is bounded, which allows ctf::format to reserve it.
+  consteval std::size_t max_size() const {
+    return ctf::detail::padded_max_size(parser,
+                                        ctf::detail::fixed_buffer_size + N);
+  }
+};
+
+#endif // CTF_FIXED_HPP
@@ -0,0 +1,269 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CTF_FLIGHT_RECORDER_HPP
+#define CTF_FLIGHT_RECORDER_HPP
+
+#include "format.hpp"
+#include "max_size.hpp"
+#include "scratch_buffer.hpp"
+#include "utility.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace ctf {
+
+// An in-memory ring of the most recent formatted messages.
+//
+// Multiple threads write concurrently without locks. A message claims a slot
+// with one atomic fetch-add on the write position. The positions only
+// increase; the byte at position p is stored at p modulo the capacity, so new
+// slots overwrite the oldest messages.
+//
+// A slot starts with a header containing its position, this is stored after
+// the message is written and publishes the slot. A reader copies a published
+// message and afterwards validates no writer claimed its bytes in the mean
+// time, so snapshots do not stop the writers. Like a seqlock the bytes of the
+// ring are accessed with relaxed atomic operations, a writer claims its slot
+// before a release fence, and the reader validates after an acquire fence.
+//
+// To find the start of a slot, the index stores for every granule of the ring
+// the position of the first slot starting in it.
+class flight_recorder {
+public:
+  struct header {
+    std::uint64_t position;
+    std::uint32_t size;
+    std::uint32_t length;
+  };
+
+  // The capacity is rounded up to a power of 2.
+  explicit flight_recorder(std::size_t capacity)
+      : capacity_(std::bit_ceil(std::max(capacity, std::size_t(1024)))),
+        granule_(std::min(capacity_ / 16, std::size_t(4096))),
+        data_(std::make_unique<std::byte[]>(capacity_)),
+        index_(std::make_unique<std::atomic<std::uint64_t>[]>(capacity_ /
+                                                              granule_)) {
+    // No slot is published, a header never contains an invalid position.
+    std::fill_n(data_.get(), capacity_, std::byte{0xff});
+    for (std::size_t i = 1; i != capacity_ / granule_; ++i)
+      index_[i].store(invalid, std::memory_order_relaxed);
+  }
+
+  flight_recorder(const flight_recorder &) = delete;
+  flight_recorder &operator=(const flight_recorder &) = delete;
+
+  std::size_t capacity() const noexcept { return capacity_; }
+
+  // The maximum size of a message, longer messages are truncated.
+  std::size_t max_message_size() const noexcept {
+    return capacity_ / 4 - sizeof(header);
+  }
+
+  // Writes a message of at most max_size bytes directly into a slot.
+  //
+  // write is called with an output iterator and returns the iterator past the
+  // end of the message.
+  template <class Write> void write(std::size_t max_size, Write write) {
+    std::uint64_t position = claim(max_size);
+    iterator first{*this, position + sizeof(header)};
+    iterator last = write(first);
+    publish(position, max_size, last.position_ - first.position_);
+  }
+
+  // Returns the messages in the ring, from old to new.
+  //
+  // Messages that are being written or overwritten while taking the snapshot
+  // are omitted.
+  std::vector<std::string> snapshot() const {
+    std::vector<std::string> result;
+    std::uint64_t end = position_.load(std::memory_order_acquire);
+    std::uint64_t begin = end > capacity_ ? end - capacity_ : 0;
+
+    std::uint64_t position =
+        find_slot((begin + granule_ - 1) / granule_ * granule_, end);
+    while (position < end) {
+      header h = load_header(position);
+      // A writer of the next cycle can be overwriting the header, so its
+      // size and length are validated before they are used.
+      if (h.position != position || !valid_slot(h)) {
+        // Not published or overwritten, continue at the next granule.
+        position = find_slot((position / granule_ + 1) * granule_, end);
+        continue;
+      }
+
+      std::string message(h.length, '\0');
+      for (std::size_t i = 0; i != h.length; ++i)
+        message[i] = static_cast<char>(
+            std::atomic_ref<std::byte>{
+                data_[(position + sizeof(header) + i) & (capacity_ - 1)]}
+                .load(std::memory_order_relaxed));
+
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (position_.load(std::memory_order_relaxed) <= position + capacity_)
+        result.push_back(std::move(message));
+      position += h.size;
+    }
+    return result;
+  }
+
+private:
+  static constexpr std::uint64_t invalid =
+      std::numeric_limits<std::uint64_t>::max();
+
+  // An output iterator writing in the ring.
+  class iterator {
+  public:
+    using difference_type = std::ptrdiff_t;
+
+    iterator(flight_recorder &recorder, std::uint64_t position) noexcept
+        : recorder_(&recorder), position_(position) {}
+
+    iterator &operator*() noexcept { return *this; }
+    iterator &operator++() noexcept { return *this; }
+    iterator &operator++(int) noexcept { return *this; }
+
+    iterator &operator=(char c) noexcept {
+      std::atomic_ref<std::byte>{
+          recorder_->data_[position_++ & (recorder_->capacity_ - 1)]}
+          .store(static_cast<std::byte>(c), std::memory_order_relaxed);
+      return *this;
+    }
+
+  private:
+    friend flight_recorder;
+
+    flight_recorder *recorder_;
+    std::uint64_t position_;
+  };
+
+  static constexpr std::size_t slot_size(std::size_t size) noexcept {
+    return (sizeof(header) + size + sizeof(header) - 1) / sizeof(header) *
+           sizeof(header);
+  }
+
+  // Claims a slot and updates the index of the granules it covers.
+  std::uint64_t claim(std::size_t size) noexcept {
+    std::size_t slot = slot_size(size);
+    std::uint64_t position =
+        position_.fetch_add(slot, std::memory_order_relaxed);
+    // A reader that sees a byte written in the slot also sees the claim.
+    std::atomic_thread_fence(std::memory_order_release);
+    std::uint64_t end = position + slot;
+    for (std::uint64_t granule = (position / granule_ + 1) * granule_;
+         granule <= end; granule += granule_)
+      index_[(granule / granule_) & (capacity_ / granule_ - 1)].store(
+          end, std::memory_order_relaxed);
+    return position;
+  }
+
+  void publish(std::uint64_t position, std::size_t size,
+               std::size_t length) noexcept {
+    std::byte *h = &data_[position & (capacity_ - 1)];
+    field<std::uint32_t>(h, offsetof(header, size))
+        .store(slot_size(size), std::memory_order_relaxed);
+    field<std::uint32_t>(h, offsetof(header, length))
+        .store(length, std::memory_order_relaxed);
+    field<std::uint64_t>(h, offsetof(header, position))
+        .store(position, std::memory_order_release);
+  }
+
+  // A torn header may contain any size and length, these are rejected.
+  bool valid_slot(const header &h) const noexcept {
+    return h.size >= sizeof(header) && h.size % sizeof(header) == 0 &&
+           h.size <= slot_size(max_message_size()) &&
+           h.length <= h.size - sizeof(header);
+  }
+
+  // The member of the header at offset, the slots are aligned to a header.
+  template <class T>
+  static std::atomic_ref<T> field(std::byte *h, std::size_t offset) noexcept {
+    return std::atomic_ref<T>{*reinterpret_cast<T *>(h + offset)};
+  }
+
+  header load_header(std::uint64_t position) const noexcept {
+    std::byte *h = &data_[position & (capacity_ - 1)];
+    header result;
+    result.position = field<std::uint64_t>(h, offsetof(header, position))
+                          .load(std::memory_order_acquire);
+    result.size = field<std::uint32_t>(h, offsetof(header, size))
+                      .load(std::memory_order_relaxed);
+    result.length = field<std::uint32_t>(h, offsetof(header, length))
+                        .load(std::memory_order_relaxed);
+    return result;
+  }
+
+  // Returns the position of the first slot starting at or after granule.
+  //
+  // Returns end when there is no such slot before end.
+  std::uint64_t find_slot(std::uint64_t granule,
+                          std::uint64_t end) const noexcept {
+    for (; granule < end; granule += granule_) {
+      std::uint64_t result =
+          index_[(granule / granule_) & (capacity_ / granule_ - 1)].load(
+              std::memory_order_relaxed);
+      // Skip entries of other cycles of the ring.
+      if (result != invalid && result >= granule &&
+          result - granule < capacity_)
+        return result;
+    }
+    return end;
+  }
+
+  std::size_t capacity_;
+  std::size_t granule_;
+  std::unique_ptr<std::byte[]> data_;
+  std::unique_ptr<std::atomic<std::uint64_t>[]> index_;
+  alignas(64) std::atomic<std::uint64_t> position_{0};
+};
+
+// Writes the output as one message in the recorder.
+//
+// When the output has an upper limit it is formatted directly in the slot,
+// otherwise it is formatted in a scratch_buffer first, so the slot has the
+// exact size.
+template <fixed_string fmt, class... Args>
+  requires std::same_as<typename decltype(fmt)::char_type, char>
+void format_to(flight_recorder &recorder, Args &&...args) {
+  constexpr auto status = parse<fmt, Args...>();
+
+  if constexpr (ctf::is_format_error(status))
+    static_assert(!"parse error", status);
+  else {
+    constexpr max_size_result bound = ctf::max_size<fmt>(status.tokens);
+    if (bound.size <= recorder.max_message_size()) {
+      recorder.write(bound.size, [&](auto out) {
+        return ctf::format_tokens_to<fmt>(out, status.tokens, args...);
+      });
+      return;
+    }
+
+    scratch_buffer<> buffer;
+    ctf::format_tokens_to<fmt>(std::back_inserter(buffer), status.tokens,
+                               args...);
+    std::string_view message = buffer.view().substr(
+        0, recorder.max_message_size());
+    recorder.write(message.size(), [&](auto out) {
+      return std::copy(message.begin(), message.end(), out);
+    });
+  }
+}
+
+} // namespace ctf
+
+#endif // CTF_FLIGHT_RECORDER_HPP
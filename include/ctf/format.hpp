@@ -11,7 +11,12 @@
 #include "format_error.hpp"
 #include "formatter.hpp"
 #include "formatter_string.hpp"
+#include "inplace_string.hpp"
+#include "max_size.hpp"
 #include "parse.hpp"
+#include "scratch_buffer.hpp"
+#include "sink.hpp"
+#include "transcoding_iterator.hpp"
 #include "tuple.hpp"
 #include "utility.hpp"
 
@@ -19,12 +24,27 @@
 #include <array>
 #include <cstddef>
 #include <format>
+#include <iterator>
+#include <span>
 #include <tuple>
 
 namespace ctf {
 
 template <fixed_string fmt, class... Args>
-constexpr std::string format(Args &&...args);
+constexpr std::basic_string<typename decltype(fmt)::char_type>
+format(Args &&...args);
+
+template <fixed_string fmt, class S, class... Args>
+  requires sink<S, typename decltype(fmt)::char_type>
+constexpr void format_to(S &sink, Args &&...args);
+
+template <fixed_string fmt, class... Args>
+  requires std::same_as<typename decltype(fmt)::char_type, char>
+constexpr auto format_inplace(Args &&...args);
+
+template <fixed_string fmt, class... Args>
+  requires std::same_as<typename decltype(fmt)::char_type, char>
+constexpr std::string format_exact(Args &&...args);
 
 struct output_char_tag {};
 struct output_text_tag {};
@@ -168,6 +188,18 @@ template <> struct format_arg<wchar_t, wchar_t> {
   using type = wchar_t;
 };
 
+template <class CharT>
+  requires(!std::same_as<formatter_char_t<CharT>, CharT>)
+struct format_arg<CharT, char> {
+  using type = char;
+};
+
+template <class CharT>
+  requires(!std::same_as<formatter_char_t<CharT>, CharT>)
+struct format_arg<CharT, char8_t> {
+  using type = char;
+};
+
 template <class CharT> struct format_arg<CharT, signed char> {
   using type = int;
 };
@@ -229,31 +261,46 @@ template <class CharT> struct format_arg<CharT, long double> {
   using type = long double;
 };
 
-template <class CharT> struct format_arg<CharT, CharT *> {
-  static_assert(std::same_as<CharT, char> || std::same_as<CharT, wchar_t>);
-  using type = std::basic_string_view<CharT>;
+// The character types of the strings that can be used for a format string
+// with the character type CharT.
+//
+// The char8_t, char16_t, and char32_t format strings use the char formatters,
+// these accept UTF-8 strings.
+template <class CharT, class S>
+concept string_char =
+    (std::same_as<S, CharT> && std::same_as<formatter_char_t<CharT>, CharT>) ||
+    (!std::same_as<CharT, char> &&
+     std::same_as<formatter_char_t<CharT>, char> &&
+     (std::same_as<S, char> || std::same_as<S, char8_t>));
+
+template <class CharT, class S>
+  requires string_char<CharT, S>
+struct format_arg<CharT, S *> {
+  using type = std::basic_string_view<formatter_char_t<CharT>>;
 };
 
-template <class CharT> struct format_arg<CharT, const CharT *> {
-  static_assert(std::same_as<CharT, char> || std::same_as<CharT, wchar_t>);
-  using type = std::basic_string_view<CharT>;
+template <class CharT, class S>
+  requires string_char<CharT, S>
+struct format_arg<CharT, const S *> {
+  using type = std::basic_string_view<formatter_char_t<CharT>>;
 };
 
-template <class CharT, std::size_t N> struct format_arg<CharT, CharT[N]> {
-  static_assert(std::same_as<CharT, char> || std::same_as<CharT, wchar_t>);
-  using type = std::basic_string_view<CharT>;
+template <class CharT, class S, std::size_t N>
+  requires string_char<CharT, S>
+struct format_arg<CharT, S[N]> {
+  using type = std::basic_string_view<formatter_char_t<CharT>>;
 };
 
-template <class CharT, class Traits>
-struct format_arg<CharT, std::basic_string_view<CharT, Traits>> {
-  static_assert(std::same_as<CharT, char> || std::same_as<CharT, wchar_t>);
-  using type = std::basic_string_view<CharT>;
+template <class CharT, class S, class Traits>
+  requires string_char<CharT, S>
+struct format_arg<CharT, std::basic_string_view<S, Traits>> {
+  using type = std::basic_string_view<formatter_char_t<CharT>>;
 };
 
-template <class CharT, class Traits, class Allocator>
-struct format_arg<CharT, std::basic_string<CharT, Traits, Allocator>> {
-  static_assert(std::same_as<CharT, char> || std::same_as<CharT, wchar_t>);
-  using type = std::basic_string_view<CharT>;
+template <class CharT, class S, class Traits, class Allocator>
+  requires string_char<CharT, S>
+struct format_arg<CharT, std::basic_string<S, Traits, Allocator>> {
+  using type = std::basic_string_view<formatter_char_t<CharT>>;
 };
 
 template <class CharT> struct format_arg<CharT, void *> {
@@ -268,6 +315,33 @@ template <class CharT> struct format_arg<CharT, nullptr_t> {
   using type = const void *;
 };
 
+// The type stored for an argument of type T while formatting.
+//
+// Arguments without a conversion are stored as a reference to the original
+// argument, this avoids copying containers, ranges, and user-defined types.
+template <class CharT, class T>
+using format_arg_t = typename format_arg<CharT, std::remove_cvref_t<T>>::type;
+
+template <class CharT, class T>
+using format_arg_value_t =
+    std::conditional_t<std::is_reference_v<format_arg_t<CharT, T>>, T &,
+                       format_arg_t<CharT, T>>;
+
+template <class CharT, class T>
+constexpr format_arg_value_t<CharT, T> as_format_arg(T &arg) {
+  using R = format_arg_value_t<CharT, T>;
+  if constexpr (std::is_reference_v<R>)
+    return arg;
+  else if constexpr (std::same_as<R, std::string_view> &&
+                     !std::constructible_from<R, T &>) {
+    // A char8_t string, a char may access the object representation of any
+    // type.
+    std::u8string_view result{arg};
+    return {reinterpret_cast<const char *>(result.data()), result.size()};
+  } else
+    return R(arg);
+}
+
 template <fixed_string fmt, class... Args>
 consteval auto handle_replacement_field3(auto status) {
   using P = decltype(status);
@@ -307,18 +381,17 @@ consteval auto handle_replacement_field3(auto status) {
     } else {
 
       using T = std::remove_reference_t<pack_type<arg_id.index, Args...>>;
+      using CharT = formatter_char_t<typename decltype(fmt)::char_type>;
 
-      if constexpr (!std::formattable<T, char>)
+      if constexpr (!std::formattable<T, CharT>)
         return ctf::create_format_error(
             "the supplied type for the argument is not formattable", fmt,
             P::offset, arg_id.offset, arg_id.offset);
 
       else {
         auto result = ctf::formatter<
-            T, fmt, arg_id.offset + std::size_t(fmt[arg_id.offset] == ':')
-
-                        ,
-
+            T, ctf::formatter_format_string<fmt>(),
+            arg_id.offset + std::size_t(fmt[arg_id.offset] == ':'),
             arg_id.status, Args...>::create();
 
         if constexpr (ctf::is_format_error(result))
@@ -376,17 +449,45 @@ template <fixed_string Fmt, class... Args> consteval auto parse(auto status) {
 }
 
 template <fixed_string fmt, class... Args> consteval auto parse() {
+  using CharT = typename decltype(fmt)::char_type;
   return parse<fmt,
-               typename format_arg<char, std::remove_cvref_t<Args>>::type...>(
+               typename format_arg<CharT, std::remove_cvref_t<Args>>::type...>(
       parser_status<0, arg_id_status<index_mode::unknown, 0, sizeof...(Args)>{},
                     tuple<>>{});
 }
 
-template <fixed_string Fmt, class... Args>
-constexpr std::string format_tokens(auto tokens, Args &...args) {
-  std::string result;
-  std::tuple t{
-      typename format_arg<char, std::remove_cvref_t<Args>>::type{args}...};
+// Formats one argument.
+//
+// The args are all arguments, these are used for the arg-ids of the width and
+// precision.
+template <class CharT, class OutIt, class F, class T, class... Args>
+OutIt format_replacement_field(const F &formatter, const T &value,
+                               std::tuple<Args...> &args, OutIt out) {
+  using Context = std::basic_format_context<OutIt, CharT>;
+
+  auto format_args = std::apply(
+      [](auto &...a) { return std::make_format_args<Context>(a...); }, args);
+  auto context =
+      std::__format_context_create<OutIt, CharT>(std::move(out), format_args);
+
+  return formatter.format(value, context);
+}
+
+// Writes the output of the tokens to the output iterator out.
+//
+// Returns the iterator past the last written element.
+template <fixed_string Fmt, class OutIt, class... Args>
+constexpr OutIt format_tokens_to(OutIt out, auto tokens, Args &...args) {
+  using CharT = typename decltype(Fmt)::char_type;
+  using FCharT = formatter_char_t<CharT>;
+
+  std::tuple<format_arg_value_t<CharT, Args>...> t{
+      ctf::as_format_arg<CharT>(args)...};
+
+  // Writing to a sink, the literal text is written as one block.
+  constexpr bool literal_sink = requires(OutIt &it, std::span<const CharT> s) {
+    it.write_literal(s);
+  };
 
   std::__for_each_index_sequence(
       std::make_index_sequence<ctf::tuple_size<decltype(tokens)>>(),
@@ -394,34 +495,110 @@ constexpr std::string format_tokens(auto tokens, Args &...args) {
         using T = ctf::tuple_type<I, decltype(tokens)>;
         const auto &token = tokens.template get<T>();
 
-        if constexpr (std::same_as<typename T::tag, output_char_tag>)
-          result.push_back(Fmt[T::offset]);
-        else if constexpr (std::same_as<typename T::tag, output_text_tag>)
-          result.append(&Fmt[T::offset], &Fmt[T::offset + T::size]);
-        else if constexpr (std::same_as<typename T::tag,
+        if constexpr (std::same_as<typename T::tag, output_char_tag>) {
+          if constexpr (literal_sink)
+            out.write_literal(std::span<const CharT>{&Fmt[T::offset], 1});
+          else
+            *out++ = Fmt[T::offset];
+        } else if constexpr (std::same_as<typename T::tag, output_text_tag>) {
+          if constexpr (literal_sink)
+            out.write_literal(
+                std::span<const CharT>{&Fmt[T::offset], T::size});
+          else
+            out = std::copy(&Fmt[T::offset], &Fmt[T::offset + T::size], out);
+        } else if constexpr (std::same_as<typename T::tag,
                                         output_replacement_field_tag>) {
 
           const auto &v = std::get<T::index>(t);
 
-          using OutIt = std::back_insert_iterator<std::string>;
-          using Context = std::basic_format_context<OutIt, char>;
+          if constexpr (std::same_as<CharT, FCharT>)
+            out = ctf::format_replacement_field<CharT>(token.formatter, v, t,
+                                                       std::move(out));
+          else
+            out = ctf::format_replacement_field<FCharT>(
+                      token.formatter, v, t,
+                      transcoding_iterator<OutIt, CharT>{std::move(out)})
+                      .base();
+        } else
+          static_assert(false, "type not supported");
+      });
+  return out;
+}
+
+template <fixed_string Fmt, class... Args>
+constexpr std::basic_string<typename decltype(Fmt)::char_type>
+format_tokens(auto tokens, Args &...args) {
+  std::basic_string<typename decltype(Fmt)::char_type> result;
+  // The sink_iterator writes the output of the formatters one element at a
+  // time, push_back is cheaper than a call to string_sink::write.
+  ctf::format_tokens_to<Fmt>(std::back_inserter(result), tokens, args...);
+  return result;
+}
 
-          auto format_args = std::make_format_args<Context>(args...);
-          auto context = std::__format_context_create<OutIt, char>(
-              std::back_inserter(result), format_args);
+// The maximum size of the output of the tokens.
+//
+// When the output is not bounded offset contains the offset of the first
+// replacement-field without an upper limit.
+struct max_size_result {
+  std::size_t size;
+  std::size_t offset;
+};
 
-          token.formatter.format(v, context);
+template <fixed_string Fmt> consteval max_size_result max_size(auto tokens) {
+  max_size_result result{0, 0};
+  std::__for_each_index_sequence(
+      std::make_index_sequence<ctf::tuple_size<decltype(tokens)>>(),
+      [&]<std::size_t I> {
+        using T = ctf::tuple_type<I, decltype(tokens)>;
+        if (result.size == unbounded)
+          return;
+
+        if constexpr (std::same_as<typename T::tag, output_char_tag>)
+          result.size += 1;
+        else if constexpr (std::same_as<typename T::tag, output_text_tag>)
+          result.size += T::size;
+        else if constexpr (std::same_as<typename T::tag,
+                                        output_replacement_field_tag>) {
+          std::size_t size =
+              ctf::formatter_max_size(tokens.template get<T>().formatter);
+          if (size == unbounded)
+            result = {unbounded, T::offset};
+          else
+            result.size += size;
         } else
           static_assert(false, "type not supported");
       });
   return result;
 }
 
+// The number of elements to reserve in a sink before writing the output.
+//
+// This is the maximum size of the output, when that is unbounded the size of
+// the literal text.
+template <fixed_string Fmt> consteval std::size_t reserve_size(auto tokens) {
+  max_size_result result = ctf::max_size<Fmt>(tokens);
+  if (result.size != unbounded)
+    return result.size;
+
+  std::size_t size = 0;
+  std::__for_each_index_sequence(
+      std::make_index_sequence<ctf::tuple_size<decltype(tokens)>>(),
+      [&]<std::size_t I> {
+        using T = ctf::tuple_type<I, decltype(tokens)>;
+        if constexpr (std::same_as<typename T::tag, output_char_tag>)
+          size += 1;
+        else if constexpr (std::same_as<typename T::tag, output_text_tag>)
+          size += T::size;
+      });
+  return size;
+}
+
 template <fixed_string fmt, class... Args>
 concept valid = !ctf::is_format_error(parse<fmt, Args...>());
 
 template <fixed_string fmt, class... Args>
-constexpr std::string format(Args &&...args) {
+constexpr std::basic_string<typename decltype(fmt)::char_type>
+format(Args &&...args) {
   constexpr auto status = parse<fmt, Args...>();
 
   if constexpr (ctf::is_format_error(status))
@@ -430,6 +607,73 @@ constexpr std::string format(Args &&...args) {
     return format_tokens<fmt>(status.tokens, args...);
 }
 
+// Writes the output to the sink.
+//
+// When the sink has a reserve member function it is called once before
+// writing the output.
+template <fixed_string fmt, class S, class... Args>
+  requires sink<S, typename decltype(fmt)::char_type>
+constexpr void format_to(S &sink, Args &&...args) {
+  constexpr auto status = parse<fmt, Args...>();
+
+  if constexpr (ctf::is_format_error(status))
+    static_assert(!"parse error", status);
+  else {
+    using CharT = typename decltype(fmt)::char_type;
+    detail::sink_reserve(sink, ctf::reserve_size<fmt>(status.tokens));
+    ctf::format_tokens_to<fmt>(sink_iterator<S, CharT>{sink}, status.tokens,
+                               args...);
+  }
+}
+
+// Formats the arguments in a ctf::inplace_string.
+//
+// The capacity of the result is the maximum size of the output. This requires
+// every replacement-field to have an upper limit for its output.
+template <fixed_string fmt, class... Args>
+  requires std::same_as<typename decltype(fmt)::char_type, char>
+constexpr auto format_inplace(Args &&...args) {
+  constexpr auto status = parse<fmt, Args...>();
+
+  if constexpr (ctf::is_format_error(status))
+    static_assert(!"parse error", status);
+  else {
+    constexpr max_size_result size = ctf::max_size<fmt>(status.tokens);
+    if constexpr (size.size == unbounded) {
+      constexpr format_error error = ctf::create_format_error(
+          "the output of the replacement-field has no upper limit", fmt,
+          size.offset, size.offset + 1, size.offset + 1);
+      static_assert(!"unbounded output", error);
+    } else {
+      inplace_string<size.size> result;
+      result.resize(ctf::format_tokens_to<fmt>(result.data(), status.tokens,
+                                               args...) -
+                    result.data());
+      return result;
+    }
+  }
+}
+
+// Formats the arguments in a string without unused capacity.
+//
+// The output is formatted in a scratch_buffer on the stack. Afterwards the
+// result is created with one allocation of the exact size. This is intended
+// for strings that are stored for a long time.
+template <fixed_string fmt, class... Args>
+  requires std::same_as<typename decltype(fmt)::char_type, char>
+constexpr std::string format_exact(Args &&...args) {
+  constexpr auto status = parse<fmt, Args...>();
+
+  if constexpr (ctf::is_format_error(status))
+    static_assert(!"parse error", status);
+  else {
+    scratch_buffer<> buffer;
+    ctf::format_tokens_to<fmt>(std::back_inserter(buffer), status.tokens,
+                               args...);
+    return buffer.str();
+  }
+}
+
 } // namespace ctf
 
 #endif // CTF_FORMAT_HPP
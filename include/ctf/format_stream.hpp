@@ -0,0 +1,303 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CTF_FORMAT_STREAM_HPP
+#define CTF_FORMAT_STREAM_HPP
+
+#include "format.hpp"
+#include "tuple.hpp"
+#include "utility.hpp"
+
+#include <concepts>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <format>
+#include <iterator>
+#include <optional>
+#include <ranges>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace ctf {
+
+// The default size of the chunks of ctf::format_stream.
+inline constexpr std::size_t format_stream_chunk_size = 4096;
+
+// A coroutine generating the output in chunks.
+//
+// The class is an input range of std::string_view. A chunk is valid until the
+// iterator is incremented.
+class chunk_generator {
+public:
+  struct promise_type {
+    chunk_generator get_return_object() noexcept {
+      return chunk_generator{
+          std::coroutine_handle<promise_type>::from_promise(*this)};
+    }
+
+    std::suspend_always initial_suspend() noexcept { return {}; }
+    std::suspend_always final_suspend() noexcept { return {}; }
+
+    std::suspend_always yield_value(std::string_view value) noexcept {
+      chunk = value;
+      return {};
+    }
+
+    void return_void() noexcept {}
+    void unhandled_exception() noexcept {
+      exception = std::current_exception();
+    }
+
+    std::string_view chunk;
+    std::exception_ptr exception;
+  };
+
+  class iterator {
+  public:
+    using value_type = std::string_view;
+    using difference_type = std::ptrdiff_t;
+
+    std::string_view operator*() const noexcept {
+      return handle_.promise().chunk;
+    }
+
+    iterator &operator++() {
+      resume(handle_);
+      return *this;
+    }
+    void operator++(int) { ++*this; }
+
+    friend bool operator==(const iterator &it, std::default_sentinel_t) {
+      return it.handle_.done();
+    }
+
+  private:
+    friend chunk_generator;
+
+    explicit iterator(std::coroutine_handle<promise_type> handle) noexcept
+        : handle_(handle) {}
+
+    std::coroutine_handle<promise_type> handle_;
+  };
+
+  chunk_generator(chunk_generator &&other) noexcept
+      : handle_(std::exchange(other.handle_, {})) {}
+  chunk_generator &operator=(chunk_generator &&other) noexcept {
+    std::swap(handle_, other.handle_);
+    return *this;
+  }
+
+  ~chunk_generator() {
+    if (handle_)
+      handle_.destroy();
+  }
+
+  // Starts formatting, this can only be called once.
+  iterator begin() {
+    resume(handle_);
+    return iterator{handle_};
+  }
+  std::default_sentinel_t end() const noexcept { return {}; }
+
+private:
+  explicit chunk_generator(std::coroutine_handle<promise_type> handle) noexcept
+      : handle_(handle) {}
+
+  // Formats the next chunk, exceptions of the formatters are rethrown.
+  static void resume(std::coroutine_handle<promise_type> handle) {
+    handle.resume();
+    if (handle.promise().exception)
+      std::rethrow_exception(std::exchange(handle.promise().exception, {}));
+  }
+
+  std::coroutine_handle<promise_type> handle_;
+};
+
+namespace detail {
+
+// Whether the replacement-field at offset has no format-spec.
+template <fixed_string fmt>
+consteval bool empty_format_spec(std::size_t offset) {
+  ++offset;
+  while (fmt[offset] >= '0' && fmt[offset] <= '9')
+    ++offset;
+  if (fmt[offset] == ':')
+    ++offset;
+  return fmt[offset] == '}';
+}
+
+// A range formatted one element at a time.
+//
+// This is limited to ranges formatted by the standard sequence formatter.
+template <class R>
+concept streamed_range =
+    std::ranges::input_range<const R> &&
+    !std::convertible_to<const R &, std::string_view> &&
+    std::format_kind<R> == std::range_format::sequence &&
+    requires(std::formatter<R, char> &f) {
+      f.set_separator(std::string_view{});
+      f.set_brackets(std::string_view{}, std::string_view{});
+    };
+
+// The position of a streamed range.
+template <class R> struct range_state {
+  using element = std::remove_cvref_t<std::ranges::range_reference_t<const R>>;
+
+  std::optional<std::ranges::iterator_t<const R>> it;
+  std::optional<std::ranges::sentinel_t<const R>> end;
+  std::formatter<element, char> formatter;
+  bool first = true;
+};
+
+// The state of the token T while streaming.
+template <fixed_string fmt, class T, class Args> consteval auto stream_state() {
+  if constexpr (!std::same_as<typename T::tag, output_replacement_field_tag>)
+    return std::type_identity<std::monostate>{};
+  else {
+    using R = std::remove_cvref_t<std::tuple_element_t<T::index, Args>>;
+    if constexpr (streamed_range<R> && empty_format_spec<fmt>(T::offset))
+      return std::type_identity<range_state<R>>{};
+    else
+      return std::type_identity<std::monostate>{};
+  }
+}
+
+template <fixed_string fmt, class Tokens, class Args, std::size_t... I>
+auto stream_states(std::index_sequence<I...>) -> std::tuple<
+    typename decltype(stream_state<fmt, ctf::tuple_type<I, Tokens>,
+                                   Args>())::type...>;
+
+template <fixed_string fmt, class Tokens, class Args>
+using stream_states_t = decltype(stream_states<fmt, Tokens, Args>(
+    std::make_index_sequence<ctf::tuple_size<Tokens>>()));
+
+// Writes the elements of range until the buffer contains a chunk.
+//
+// The output matches the standard formatter with an empty format-spec.
+// Returns whether the range is completely written.
+template <class R, class Args>
+bool stream_elements(const R &range, range_state<R> &state, Args &args,
+                     std::string &buffer, std::size_t chunk_size) {
+  if (!state.it) {
+    std::basic_format_parse_context<char> parse_ctx{std::string_view{}};
+    state.formatter.parse(parse_ctx);
+    if constexpr (requires { state.formatter.set_debug_format(); })
+      state.formatter.set_debug_format();
+
+    state.it = std::ranges::begin(range);
+    state.end = std::ranges::end(range);
+    buffer.push_back('[');
+  }
+
+  for (; *state.it != *state.end; ++*state.it) {
+    if (buffer.size() >= chunk_size)
+      return false;
+    if (!std::exchange(state.first, false))
+      buffer.append(", ");
+    ctf::format_replacement_field<char>(state.formatter, **state.it, args,
+                                        std::back_inserter(buffer));
+  }
+  buffer.push_back(']');
+  return true;
+}
+
+// Writes the output of token i to the buffer.
+//
+// Returns whether the token is completely written.
+template <fixed_string fmt, class Tokens, class States, class Args>
+bool stream_token(std::size_t i, const Tokens &tokens, States &states,
+                  Args &args, std::string &buffer, std::size_t chunk_size) {
+  bool result = true;
+  std::__for_each_index_sequence(
+      std::make_index_sequence<ctf::tuple_size<Tokens>>(), [&]<std::size_t I> {
+        if (I != i)
+          return;
+
+        using T = ctf::tuple_type<I, Tokens>;
+        if constexpr (std::same_as<typename T::tag, output_char_tag>)
+          buffer.push_back(fmt[T::offset]);
+        else if constexpr (std::same_as<typename T::tag, output_text_tag>)
+          buffer.append(&fmt[T::offset], T::size);
+        else if constexpr (std::same_as<typename T::tag,
+                                        output_replacement_field_tag>) {
+          const auto &v = std::get<T::index>(args);
+          auto &state = std::get<I>(states);
+          if constexpr (std::same_as<std::remove_cvref_t<decltype(state)>,
+                                     std::monostate>)
+            ctf::format_replacement_field<char>(
+                tokens.template get<T>().formatter, v, args,
+                std::back_inserter(buffer));
+          else
+            result = detail::stream_elements(v, state, args, buffer,
+                                             chunk_size);
+        } else
+          static_assert(false, "type not supported");
+      });
+  return result;
+}
+
+template <fixed_string fmt, std::size_t chunk_size, class... Args>
+chunk_generator format_stream(std::tuple<Args...> values) {
+  constexpr auto status = parse<fmt, Args...>();
+  using Tokens = decltype(status.tokens);
+
+  auto args = std::apply(
+      [](auto &...a) {
+        return std::tuple<format_arg_value_t<char, Args>...>{
+            ctf::as_format_arg<char>(a)...};
+      },
+      values);
+  stream_states_t<fmt, Tokens, decltype(args)> states;
+
+  std::string buffer;
+  buffer.reserve(2 * chunk_size);
+  for (std::size_t i = 0; i != ctf::tuple_size<Tokens>;) {
+    if (detail::stream_token<fmt>(i, status.tokens, states, args, buffer,
+                                  chunk_size))
+      ++i;
+
+    std::size_t offset = 0;
+    for (; buffer.size() - offset >= chunk_size; offset += chunk_size)
+      co_yield std::string_view{buffer}.substr(offset, chunk_size);
+    buffer.erase(0, offset);
+  }
+  if (!buffer.empty())
+    co_yield std::string_view{buffer};
+}
+
+} // namespace detail
+
+// Formats the arguments in chunks of chunk_size characters.
+//
+// The output is created while iterating over the result, so only one chunk is
+// kept in memory. A range argument with an empty format-spec is formatted one
+// element at a time, so a large range does not need to be formatted at once.
+// Only the last chunk may be smaller than chunk_size.
+//
+// The arguments are stored by reference for lvalues and by value for rvalues.
+template <fixed_string fmt, std::size_t chunk_size = format_stream_chunk_size,
+          class... Args>
+  requires std::same_as<typename decltype(fmt)::char_type, char> &&
+           (chunk_size > 0)
+chunk_generator format_stream(Args &&...args) {
+  constexpr auto status = parse<fmt, Args...>();
+
+  if constexpr (ctf::is_format_error(status))
+    static_assert(!"parse error", status);
+  else
+    return detail::format_stream<fmt, chunk_size, Args...>(
+        std::tuple<Args...>{std::forward<Args>(args)...});
+}
+
+} // namespace ctf
+
+#endif // CTF_FORMAT_STREAM_HPP
@@ -67,8 +67,9 @@ struct formatter {
       F f;
 
       // &fmt[fmt::size()] is valid; it points to the NUL terminator.
-      std::format_parse_context parse_ctx{
-          std::string_view{&fmt[begin], &fmt[fmt.size()]}, sizeof...(Args)};
+      std::basic_format_parse_context<CharT> parse_ctx{
+          std::basic_string_view<CharT>{&fmt[begin], &fmt[fmt.size()]},
+          sizeof...(Args)};
       auto it = f.parse(parse_ctx);
 
       if (it != &fmt[end])
@@ -14,6 +14,7 @@
 #error This header requires libc++'s format implementation
 #endif
 
+#include "escape.hpp"
 #include "formatter.hpp"
 #include "parse.hpp"
 #include "utility.hpp"
@@ -26,13 +27,12 @@
 namespace ctf {
 namespace detail {
 
-using CharT = char;
-
-template <std::size_t o, arg_id_status i, std::__format_spec::__parser<CharT> p>
-struct parse_status {
+// The character type of the format string is not a template argument; the
+// parser p is a std::__format_spec::__parser<CharT> of that character type.
+template <std::size_t o, arg_id_status i, auto p> struct parse_status {
   static constexpr std::size_t offset = o;
   static constexpr arg_id_status arg_id = i;
-  static constexpr std::__format_spec::__parser<CharT> parser = p;
+  static constexpr decltype(p) parser = p;
 };
 
 /***** FILL AND ALIGN *****/
@@ -44,13 +44,15 @@ struct parse_status {
 // fill it's not sure the value is a fill, that is determined by the character
 // after the fill. Since the entire format spec is valid Unicode there are no
 // false positives.
-template <std::size_t o, std::__format_spec::__code_point<char> v>
-struct fill_result {
+//
+// The value v is a std::__format_spec::__code_point<CharT>.
+template <std::size_t o, auto v> struct fill_result {
   static constexpr std::size_t offset = o;
-  static constexpr std::__format_spec::__code_point<char> value = v;
+  static constexpr decltype(v) value = v;
 };
 
-template <fixed_string fmt, parse_status status> consteval auto parse_fill() {
+template <fixed_string fmt, parse_status status>
+consteval auto parse_fill_utf8() {
   auto consume = [&]<fill_result fill, std::size_t index> {
     constexpr char code_unit = fmt[fill.offset];
     if constexpr ((code_unit & 0b1100'0000) != 0b1000'0000)
@@ -95,22 +97,57 @@ template <fixed_string fmt, parse_status status> consteval auto parse_fill() {
   }
 }
 
-consteval std::__format_spec::__alignment get_alignment(char c) {
+// A wchar_t is either UTF-16 or UTF-32. For UTF-16 a code point outside the
+// BMP is stored as a surrogate pair, for UTF-32 every code point is one code
+// unit.
+template <fixed_string fmt, parse_status status>
+consteval auto parse_fill_wide() {
+  using CharT = typename decltype(fmt)::char_type;
+  constexpr auto c = static_cast<std::uint32_t>(fmt[status.offset]);
+  if constexpr (c >= 0xDC00 && c < 0xE000)
+    return create_format_error("the code point is a low surrogate", fmt,
+                               status.offset, status.offset, status.offset);
+  else if constexpr (c < 0xD800 || c >= 0xE000)
+    return fill_result<status.offset + 1,
+                       std::__format_spec::__code_point<CharT>{CharT(c)}>{};
+  else if constexpr (sizeof(CharT) != 2)
+    return create_format_error("the code point is a high surrogate", fmt,
+                               status.offset, status.offset, status.offset);
+  else {
+    constexpr auto low = static_cast<std::uint32_t>(fmt[status.offset + 1]);
+    if constexpr (low < 0xDC00 || low >= 0xE000)
+      return create_format_error("expected UTF-16 low surrogate", fmt,
+                                 status.offset, status.offset + 1,
+                                 status.offset + 1);
+    else
+      return fill_result<status.offset + 2,
+                         std::__format_spec::__code_point<CharT>{
+                             CharT(c), CharT(low)}>{};
+  }
+}
+
+template <fixed_string fmt, parse_status status> consteval auto parse_fill() {
+  if constexpr (sizeof(typename decltype(fmt)::char_type) == 1)
+    return parse_fill_utf8<fmt, status>();
+  else
+    return parse_fill_wide<fmt, status>();
+}
+
+template <class CharT>
+consteval std::__format_spec::__alignment get_alignment(CharT c) {
   switch (c) {
-  case '<':
+  case CharT('<'):
     return std::__format_spec::__alignment::__left;
-  case '^':
+  case CharT('^'):
     return std::__format_spec::__alignment::__center;
-  case '>':
+  case CharT('>'):
     return std::__format_spec::__alignment::__right;
   }
   return std::__format_spec::__alignment::__default;
 }
 
-template <std::__format_spec::__parser<CharT> parser,
-          std::__format_spec::__code_point<char> fill,
-          std::__format_spec::__alignment alignment>
-consteval std::__format_spec::__parser<CharT> set_fill_align() {
+template <auto parser, auto fill, std::__format_spec::__alignment alignment>
+consteval decltype(parser) set_fill_align() {
   return {.__alignment_ = alignment,
           .__sign_ = parser.__sign_,
           .__alternate_form_ = parser.__alternate_form_,
@@ -164,9 +201,9 @@ consteval auto parse_fill_align() {
 
 /***** SIGN *****/
 
-template <std::__format_spec::__parser<CharT> parser,
+template <auto parser,
           std::__format_spec::__sign sign>
-consteval std::__format_spec::__parser<CharT> set_sign() {
+consteval decltype(parser) set_sign() {
   return {
       .__alignment_ = parser.__alignment_,
       .__sign_ = sign,
@@ -191,6 +228,7 @@ consteval std::__format_spec::__parser<CharT> set_sign() {
 }
 
 template <fixed_string fmt, parse_status status> consteval auto parse_sign() {
+  using CharT = typename decltype(fmt)::char_type;
   auto consume = [&]<std::__format_spec::__sign sign> {
     return parse_status<status.offset + 1, status.arg_id,
                         set_sign<status.parser, sign>()>{};
@@ -221,8 +259,8 @@ consteval auto parse_sign() {
 
 /***** ALTERNATE FORM *****/
 
-template <std::__format_spec::__parser<CharT> parser>
-consteval std::__format_spec::__parser<CharT> set_alternate_form() {
+template <auto parser>
+consteval decltype(parser) set_alternate_form() {
   return {
       .__alignment_ = parser.__alignment_,
       .__sign_ = parser.__sign_,
@@ -248,6 +286,7 @@ consteval std::__format_spec::__parser<CharT> set_alternate_form() {
 
 template <fixed_string fmt, parse_status status>
 consteval auto parse_alternate_form() {
+  using CharT = typename decltype(fmt)::char_type;
   if constexpr (fmt[status.offset] == CharT('#'))
     return parse_status<status.offset + 1, status.arg_id,
                         set_alternate_form<status.parser>()>{};
@@ -273,8 +312,8 @@ consteval auto parse_alternate_form() {
 // The usage of the option is still valid so the option needs to be consumed or
 // raise an error when invalid.
 
-template <std::__format_spec::__parser<CharT> parser>
-consteval std::__format_spec::__parser<CharT> set_zero_padding() {
+template <auto parser>
+consteval decltype(parser) set_zero_padding() {
   return {
       .__alignment_ =
           (parser.__alignment_ == std::__format_spec::__alignment::__default
@@ -303,6 +342,7 @@ consteval std::__format_spec::__parser<CharT> set_zero_padding() {
 
 template <fixed_string fmt, parse_status status>
 consteval auto parse_zero_padding() {
+  using CharT = typename decltype(fmt)::char_type;
   if constexpr (fmt[status.offset] == CharT('0'))
     return parse_status<status.offset + 1, status.arg_id,
                         set_zero_padding<status.parser>()>{};
@@ -324,9 +364,9 @@ consteval auto parse_zero_padding() {
 
 /***** WIDTH *****/
 
-template <std::__format_spec::__parser<CharT> parser, int32_t width,
+template <auto parser, int32_t width,
           bool width_as_arg>
-consteval std::__format_spec::__parser<CharT> set_width() {
+consteval decltype(parser) set_width() {
   return {
       .__alignment_ = parser.__alignment_,
       .__sign_ = parser.__sign_,
@@ -358,6 +398,7 @@ template <std::size_t O, std::size_t I> struct get_arg_id_result {
 template <fixed_string fmt, std::size_t begin, // at opening curly
           std::size_t arg_id, class... Args>
 consteval auto get_arg_id() {
+  using CharT = typename decltype(fmt)::char_type;
   constexpr auto c = fmt[begin + 1];
   if constexpr (c == CharT('}')) {
     if constexpr (arg_id != -1)
@@ -375,6 +416,7 @@ consteval auto get_arg_id() {
 template <fixed_string fmt, std::size_t begin, parse_status status,
           class... Args>
 consteval auto parse_width() {
+  using CharT = typename decltype(fmt)::char_type;
   constexpr auto c = fmt[status.offset];
   if constexpr (c == CharT('{')) {
     // Note this code needs to be shared between width and precision.
@@ -457,9 +499,9 @@ consteval auto parse_width() {
 
 /***** PRECISION *****/
 
-template <std::__format_spec::__parser<CharT> parser, int32_t precision,
+template <auto parser, int32_t precision,
           bool precision_as_arg>
-consteval std::__format_spec::__parser<CharT> set_precision() {
+consteval decltype(parser) set_precision() {
   return {
       .__alignment_ = parser.__alignment_,
       .__sign_ = parser.__sign_,
@@ -487,6 +529,7 @@ template <fixed_string fmt, std::size_t begin,
           std::__format_spec::__fields fields, parse_status status,
           class... Args>
 consteval auto parse_precision() {
+  using CharT = typename decltype(fmt)::char_type;
 
   constexpr auto c = fmt[status.offset];
 
@@ -579,8 +622,8 @@ consteval auto parse_precision() {
 
 /***** LOCALE-SPECIFIC FORM *****/
 
-template <std::__format_spec::__parser<CharT> parser>
-consteval std::__format_spec::__parser<CharT> set_locale_specific_form() {
+template <auto parser>
+consteval decltype(parser) set_locale_specific_form() {
   return {
       .__alignment_ = parser.__alignment_,
       .__sign_ = parser.__sign_,
@@ -606,6 +649,7 @@ consteval std::__format_spec::__parser<CharT> set_locale_specific_form() {
 
 template <fixed_string fmt, parse_status status>
 consteval auto parse_locale_specific_form() {
+  using CharT = typename decltype(fmt)::char_type;
   if constexpr (fmt[status.offset] == CharT('L'))
     return parse_status<status.offset + 1, status.arg_id,
                         set_locale_specific_form<status.parser>()>{};
@@ -628,8 +672,8 @@ consteval auto parse_locale_specific_form() {
 
 /***** CLEAR BRACKETS *****/
 
-template <std::__format_spec::__parser<CharT> parser>
-consteval std::__format_spec::__parser<CharT> set_clear_brackets() {
+template <auto parser>
+consteval decltype(parser) set_clear_brackets() {
   return {
       .__alignment_ = parser.__alignment_,
       .__sign_ = parser.__sign_,
@@ -655,6 +699,7 @@ consteval std::__format_spec::__parser<CharT> set_clear_brackets() {
 
 template <fixed_string fmt, parse_status status>
 consteval auto parse_clear_brackets() {
+  using CharT = typename decltype(fmt)::char_type;
   if constexpr (fmt[status.offset] == CharT('n'))
     return parse_status<status.offset + 1, status.arg_id,
                         set_clear_brackets<status.parser>()>{};
@@ -676,9 +721,9 @@ consteval auto parse_clear_brackets() {
 
 /***** TYPE *****/
 
-template <std::__format_spec::__parser<CharT> parser,
+template <auto parser,
           std::__format_spec::__type type>
-consteval std::__format_spec::__parser<CharT> set_type() {
+consteval decltype(parser) set_type() {
   return {
       .__alignment_ = parser.__alignment_,
       .__sign_ = parser.__sign_,
@@ -705,6 +750,7 @@ consteval std::__format_spec::__parser<CharT> set_type() {
 template <fixed_string fmt, std::size_t begin,
           std::__format_spec::__fields fields, parse_status status>
 consteval auto parse_type() {
+  using CharT = typename decltype(fmt)::char_type;
   auto consume = [&]<std::__format_spec::__type type> {
     return parse_status<status.offset + 1, status.arg_id,
                         set_type<status.parser, type>()>{};
@@ -773,6 +819,7 @@ consteval auto parse() {
   // Note from all fields only 1 flag can be send the function.
   // This reduces the number of instantiations.
   //
+  using CharT = typename decltype(fmt)::char_type;
 
   if constexpr (begin == fmt.size())
     return status;
@@ -853,18 +900,70 @@ consteval auto process_parsed_string() {
         status.offset - 1, status.offset - 1);
 }
 
+/***** ESCAPING *****/
+
+// The escaping display types are not known by libc++'s parser. They are
+// parsed after the other options, so the string fields don't consume all
+// characters.
+inline constexpr std::__format_spec::__fields fields_escaped_string = [] {
+  std::__format_spec::__fields result = std::__format_spec::__fields_string;
+  result.__consume_all_ = false;
+  return result;
+}();
+
+template <std::size_t o, escape_kind k> struct escape_result {
+  static constexpr std::size_t offset = o;
+  static constexpr escape_kind kind = k;
+};
+
+template <fixed_string fmt, std::size_t begin, parse_status status>
+consteval auto parse_escape() {
+  using CharT = typename decltype(fmt)::char_type;
+  constexpr auto c = fmt[status.offset];
+  constexpr escape_kind kind = c == CharT('j')   ? escape_kind::json
+                               : c == CharT('h') ? escape_kind::html
+                               : c == CharT('u') ? escape_kind::url
+                                                 : escape_kind::none;
+  constexpr std::size_t offset = status.offset + (kind != escape_kind::none);
+
+  if constexpr (offset != fmt.size() && fmt[offset] != CharT('}'))
+    return create_format_error(
+        "unexpected character at the end of the format specification", fmt,
+        begin, offset, offset);
+  else if constexpr (kind == escape_kind::none)
+    return escape_result<offset, kind>{};
+  else if constexpr (!std::same_as<CharT, char>)
+    return create_format_error(
+        "the escaping display types require a char format string", fmt, begin,
+        status.offset, status.offset);
+  else if constexpr (status.parser.__type_ !=
+                     std::__format_spec::__type::__default)
+    return create_format_error(
+        "the escaping display type can't be combined with another display "
+        "type",
+        fmt, begin, status.offset, status.offset);
+  else if constexpr (status.parser.__precision_as_arg_ ||
+                     status.parser.__precision_ != -1)
+    return create_format_error(
+        "the escaping display types do not allow the precision option", fmt,
+        begin, status.offset, status.offset);
+  else
+    return escape_result<offset, kind>{};
+}
+
 } // namespace detail
 
-template <fixed_string fmt, std::size_t begin, arg_id_status arg_id,
-          class... Args>
-struct formatter<std::basic_string_view<char>, fmt, begin, arg_id, Args...> {
+template <class CharT, fixed_string fmt, std::size_t begin,
+          arg_id_status arg_id, class... Args>
+  requires std::same_as<CharT, typename decltype(fmt)::char_type>
+struct formatter<std::basic_string_view<CharT>, fmt, begin, arg_id, Args...> {
 
   static consteval auto create() {
 
     auto status = detail::parse<
-        fmt, begin, std::__format_spec::__fields_string,
+        fmt, begin, detail::fields_escaped_string,
         detail::parse_status<begin, arg_id,
-                             std::__format_spec::__parser<char>{
+                             std::__format_spec::__parser<CharT>{
                                  std::__format_spec::__alignment::__left}>{},
         Args...>();
 
@@ -872,12 +971,20 @@ struct formatter<std::basic_string_view<char>, fmt, begin, arg_id, Args...> {
       return status;
     else {
       auto result = detail::process_parsed_string<fmt, begin, status>();
+      auto escape = detail::parse_escape<fmt, begin, status>();
       if constexpr (ctf::is_format_error(result))
         return result;
+      else if constexpr (ctf::is_format_error(escape))
+        return escape;
       else {
-        using F = std::formatter<std::basic_string_view<char>>;
-        return formatter_result<result.offset, result.arg_id, F>{
-            F{result.parser}};
+        using F = std::formatter<std::basic_string_view<CharT>, CharT>;
+        if constexpr (escape.kind == escape_kind::none)
+          return formatter_result<escape.offset, result.arg_id, F>{
+              F{result.parser}};
+        else
+          return formatter_result<escape.offset, result.arg_id,
+                                  escape_formatter<escape.kind>>{
+              escape_formatter<escape.kind>{F{result.parser}}};
       }
     }
   }
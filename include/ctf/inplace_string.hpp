@@ -0,0 +1,75 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CTF_INPLACE_STRING_HPP
+#define CTF_INPLACE_STRING_HPP
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace ctf {
+
+// A string with a fixed capacity stored inside the object.
+//
+// This is the result type of ctf::format_inplace. The capacity is the maximum
+// size of the output, as determined while parsing the format string, so the
+// formatting functions never need to check the remaining capacity.
+//
+// The buffer is not initialized, only the first size() elements are valid.
+template <std::size_t N> class inplace_string {
+public:
+  using value_type = char;
+  using size_type = std::size_t;
+  using iterator = char *;
+  using const_iterator = const char *;
+
+  constexpr inplace_string() noexcept = default;
+
+  static constexpr size_type capacity() noexcept { return N; }
+  constexpr size_type size() const noexcept { return size_; }
+  constexpr bool empty() const noexcept { return size_ == 0; }
+
+  constexpr char *data() noexcept { return data_; }
+  constexpr const char *data() const noexcept { return data_; }
+
+  constexpr iterator begin() noexcept { return data_; }
+  constexpr const_iterator begin() const noexcept { return data_; }
+  constexpr iterator end() noexcept { return data_ + size_; }
+  constexpr const_iterator end() const noexcept { return data_ + size_; }
+
+  constexpr char &operator[](size_type i) noexcept { return data_[i]; }
+  constexpr const char &operator[](size_type i) const noexcept {
+    return data_[i];
+  }
+
+  // Sets the size after writing directly into data().
+  //
+  // Unlike std::string::resize this does not initialize the elements.
+  // Precondition: n <= capacity()
+  constexpr void resize(size_type n) noexcept { size_ = n; }
+
+  constexpr std::string_view view() const noexcept { return {data_, size_}; }
+  constexpr operator std::string_view() const noexcept { return view(); }
+
+  constexpr std::string str() const { return std::string{data_, size_}; }
+
+  friend constexpr bool operator==(const inplace_string &lhs,
+                                   std::string_view rhs) noexcept {
+    return lhs.view() == rhs;
+  }
+
+private:
+  // A zero sized array is not valid; formats without output still need a
+  // valid object.
+  char data_[N ? N : 1];
+  size_type size_{0};
+};
+
+} // namespace ctf
+
+#endif // CTF_INPLACE_STRING_HPP
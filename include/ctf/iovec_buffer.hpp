@@ -0,0 +1,100 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CTF_IOVEC_BUFFER_HPP
+#define CTF_IOVEC_BUFFER_HPP
+
+#include "format.hpp"
+#include "utility.hpp"
+
+#include <concepts>
+#include <cstddef>
+#include <span>
+#include <string>
+#include <vector>
+
+#include <sys/uio.h>
+
+namespace ctf {
+
+// A list of iovec entries for writev or sendmsg.
+//
+// The literal text of the format string is not copied, its entries point to
+// the format string. The format string is a template parameter object, so it
+// lives until the end of the program. The output of the replacement-fields is
+// stored in a scratch buffer owned by this object. Consecutive output of
+// replacement-fields uses one entry.
+//
+// Multiple outputs can be added to the same buffer, clear removes them and
+// keeps the allocated memory.
+class iovec_buffer {
+public:
+  void write(std::span<const char> data) {
+    if (entries_.empty() || entries_.back().literal != nullptr ||
+        entries_.back().offset + entries_.back().size != scratch_.size())
+      entries_.push_back({nullptr, scratch_.size(), 0});
+
+    scratch_.append(data.data(), data.size());
+    entries_.back().size += data.size();
+  }
+
+  void write_literal(std::span<const char> data) {
+    entries_.push_back({data.data(), 0, data.size()});
+  }
+
+  void clear() noexcept {
+    entries_.clear();
+    scratch_.clear();
+  }
+
+  // Returns the total number of bytes of the entries.
+  std::size_t size() const noexcept {
+    std::size_t result = 0;
+    for (const entry &e : entries_)
+      result += e.size;
+    return result;
+  }
+
+  // Returns the entries.
+  //
+  // The scratch buffer may be reallocated while formatting, so the pointers to
+  // it are only determined here. The result is valid until the next
+  // modification of the buffer.
+  std::span<const iovec> iov() {
+    iov_.resize(entries_.size());
+    for (std::size_t i = 0; i != entries_.size(); ++i) {
+      const entry &e = entries_[i];
+      iov_[i].iov_base = const_cast<char *>(
+          e.literal != nullptr ? e.literal : scratch_.data() + e.offset);
+      iov_[i].iov_len = e.size;
+    }
+    return iov_;
+  }
+
+private:
+  struct entry {
+    // The literal text, nullptr when the data is in the scratch buffer.
+    const char *literal;
+    std::size_t offset;
+    std::size_t size;
+  };
+
+  std::vector<entry> entries_;
+  std::string scratch_;
+  std::vector<iovec> iov_;
+};
+
+// Appends the output to buffer without copying the literal text.
+template <fixed_string fmt, class... Args>
+  requires std::same_as<typename decltype(fmt)::char_type, char>
+void format_iov(iovec_buffer &buffer, Args &&...args) {
+  ctf::format_to<fmt>(buffer, args...);
+}
+
+} // namespace ctf
+
+#endif // CTF_IOVEC_BUFFER_HPP
@@ -0,0 +1,107 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CTF_LAZY_HPP
+#define CTF_LAZY_HPP
+
+#include "format.hpp"
+#include "sink.hpp"
+#include "utility.hpp"
+
+#include <concepts>
+#include <format>
+#include <iterator>
+#include <string>
+#include <tuple>
+#include <utility>
+
+namespace ctf {
+
+// The arguments of a format string, formatted when the output is used.
+//
+// The arguments are stored by reference for lvalues and by value for rvalues.
+// So the object should not outlive its lvalue arguments.
+//
+// The output is created when the object is converted to a string, written to
+// a sink, or used as argument of another format function. In the latter case
+// the output is written directly in the output of that function.
+template <fixed_string fmt, class... Args> class lazy_format {
+public:
+  using char_type = typename decltype(fmt)::char_type;
+
+  constexpr explicit lazy_format(Args &&...args)
+      : args_(std::forward<Args>(args)...) {}
+
+  // Writes the output to the output iterator out.
+  //
+  // Returns the iterator past the last written element.
+  template <class OutIt> constexpr OutIt format_to(OutIt out) const {
+    return std::apply(
+        [&](auto &...args) {
+          return ctf::format_tokens_to<fmt>(std::move(out), status.tokens,
+                                            args...);
+        },
+        args_);
+  }
+
+  constexpr std::basic_string<char_type> str() const {
+    std::basic_string<char_type> result;
+    // Like ctf::format the output is appended with push_back.
+    format_to(std::back_inserter(result));
+    return result;
+  }
+
+  constexpr operator std::basic_string<char_type>() const { return str(); }
+
+private:
+  static constexpr auto status = parse<fmt, Args...>();
+
+  std::tuple<Args...> args_;
+};
+
+// Returns an object formatting the arguments when its output is used.
+template <fixed_string fmt, class... Args>
+constexpr lazy_format<fmt, Args...> lazy(Args &&...args) {
+  constexpr auto status = parse<fmt, Args...>();
+
+  if constexpr (ctf::is_format_error(status))
+    static_assert(!"parse error", status);
+  else
+    return lazy_format<fmt, Args...>{std::forward<Args>(args)...};
+}
+
+// Writes the output of value to the sink.
+template <class S, fixed_string fmt, class... Args>
+  requires sink<S, typename decltype(fmt)::char_type>
+constexpr void format_to(S &sink, const lazy_format<fmt, Args...> &value) {
+  using CharT = typename decltype(fmt)::char_type;
+  value.format_to(sink_iterator<S, CharT>{sink});
+}
+
+} // namespace ctf
+
+// Formats a lazy_format as argument of another format function.
+//
+// The format-spec needs to be empty.
+template <ctf::fixed_string fmt, class... Args, class CharT>
+  requires std::same_as<CharT, typename decltype(fmt)::char_type>
+struct std::formatter<ctf::lazy_format<fmt, Args...>, CharT> {
+  constexpr auto parse(std::basic_format_parse_context<CharT> &ctx) {
+    auto it = ctx.begin();
+    if (it != ctx.end() && *it != CharT('}'))
+      throw std::format_error("a lazy format does not accept a format-spec");
+    return it;
+  }
+
+  template <class FormatContext>
+  auto format(const ctf::lazy_format<fmt, Args...> &value,
+              FormatContext &ctx) const {
+    return value.format_to(ctx.out());
+  }
+};
+
+#endif // CTF_LAZY_HPP
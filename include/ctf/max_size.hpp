@@ -0,0 +1,163 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CTF_MAX_SIZE_HPP
+#define CTF_MAX_SIZE_HPP
+
+// This uses libc++'s implementation details to inspect the parsed formatters.
+#include <version>
+#ifndef _LIBCPP_VERSION
+#error This header requires libc++'s format implementation
+#endif
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <format>
+#include <string_view>
+#include <type_traits>
+
+namespace ctf {
+
+// The value used when the output of a formatter has no upper limit.
+inline constexpr std::size_t unbounded = std::size_t(-1);
+
+namespace detail {
+
+// The number of digits of the largest value of T in the given base.
+//
+// For signed types the magnitude of the minimum value is never larger than
+// the maximum of its unsigned counterpart.
+template <class T> consteval std::size_t max_digits(unsigned base) {
+  using U = std::make_unsigned_t<T>;
+  std::size_t result = 1;
+  for (U v = U(-1); v >= base; v /= base)
+    ++result;
+  return result;
+}
+
+template <class CharT>
+consteval std::size_t
+fill_size(const std::__format_spec::__parser<CharT> &parser) {
+  if constexpr (sizeof(CharT) == 1) {
+    int bits =
+        std::countl_one(static_cast<unsigned char>(parser.__fill_.__data[0]));
+    return bits == 0 ? 1 : bits;
+  } else
+    return 1;
+}
+
+// Adds the padding to the maximum size of the formatted value.
+//
+// The bounded values are all ASCII, so their column width equals their size.
+// This means the padding fills the output up to the width and the only
+// additional code units are those of a multi code unit fill character.
+template <class CharT>
+consteval std::size_t
+padded_max_size(const std::__format_spec::__parser<CharT> &parser,
+                std::size_t size) {
+  if (parser.__width_as_arg_)
+    return unbounded;
+
+  return std::max(size, parser.__width_ * fill_size(parser));
+}
+
+template <class T, class CharT>
+consteval std::size_t
+integral_max_size(const std::__format_spec::__parser<CharT> &parser) {
+  // The sign is always counted.
+  std::size_t result = 1;
+  using enum std::__format_spec::__type;
+  switch (parser.__type_) {
+  case __binary_lower_case:
+  case __binary_upper_case:
+    result += 2 + max_digits<T>(2);
+    break;
+  case __octal:
+    result += 1 + max_digits<T>(8);
+    break;
+  case __hexadecimal_lower_case:
+  case __hexadecimal_upper_case:
+    result += 2 + max_digits<T>(16);
+    break;
+  case __char:
+    return padded_max_size(parser, 1);
+  default:
+    result += max_digits<T>(10);
+    break;
+  }
+
+  // Every group contains at least one digit, so a grouping separator can at
+  // most be added between every digit.
+  if (parser.__locale_specific_form_)
+    result *= 2;
+
+  return padded_max_size(parser, result);
+}
+
+} // namespace detail
+
+// Returns the maximum number of code units the formatter writes.
+//
+// Returns unbounded when there is no upper limit. Besides formatters without
+// an upper limit this is used for formatters that are not known.
+//
+// Strings are never bounded. Their precision is not a number of code units,
+// but an estimated column width. An extended grapheme cluster with its
+// combining code points counts as one or two columns, regardless of its size.
+template <class F>
+consteval std::size_t formatter_max_size(const F &formatter) {
+  using CharT = char;
+  if constexpr (std::same_as<F, std::formatter<bool, CharT>>) {
+    // The locale's truename and falsename have no upper limit.
+    if (formatter.__parser_.__locale_specific_form_)
+      return unbounded;
+    // "false" is longer than every integral presentation.
+    return detail::padded_max_size(formatter.__parser_, 5);
+  }
+
+  else if constexpr (std::same_as<F, std::formatter<CharT, CharT>>) {
+    using enum std::__format_spec::__type;
+    switch (formatter.__parser_.__type_) {
+    case __default:
+    case __char:
+      return detail::padded_max_size(formatter.__parser_, 1);
+    case __debug:
+      // The largest escape sequence is '\x{XX}'.
+      return detail::padded_max_size(formatter.__parser_, 8);
+    default:
+      return detail::integral_max_size<unsigned char>(formatter.__parser_);
+    }
+
+  } else if constexpr (std::same_as<F, std::formatter<int, CharT>>)
+    return detail::integral_max_size<int>(formatter.__parser_);
+  else if constexpr (std::same_as<F, std::formatter<unsigned, CharT>>)
+    return detail::integral_max_size<unsigned>(formatter.__parser_);
+  else if constexpr (std::same_as<F, std::formatter<long long, CharT>>)
+    return detail::integral_max_size<long long>(formatter.__parser_);
+  else if constexpr (std::same_as<F, std::formatter<unsigned long long, CharT>>)
+    return detail::integral_max_size<unsigned long long>(formatter.__parser_);
+  else if constexpr (std::same_as<F, std::formatter<__int128_t, CharT>>)
+    return detail::integral_max_size<__int128_t>(formatter.__parser_);
+  else if constexpr (std::same_as<F, std::formatter<__uint128_t, CharT>>)
+    return detail::integral_max_size<__uint128_t>(formatter.__parser_);
+
+  else if constexpr (std::same_as<F, std::formatter<const void *, CharT>>)
+    // 0x followed by the hexadecimal digits of the address.
+    return detail::padded_max_size(formatter.__parser_,
+                                   2 + 2 * sizeof(const void *));
+
+  else if constexpr (requires { formatter.max_size(); })
+    // A formatter of this library with a bounded output.
+    return formatter.max_size();
+  else
+    return unbounded;
+}
+
+} // namespace ctf
+
+#endif // CTF_MAX_SIZE_HPP
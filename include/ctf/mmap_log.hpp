@@ -0,0 +1,222 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CTF_MMAP_LOG_HPP
+#define CTF_MMAP_LOG_HPP
+
+#include "format.hpp"
+#include "scratch_buffer.hpp"
+#include "utility.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <concepts>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ctf {
+
+// The default size of the regions of a mmap_log.
+inline constexpr std::size_t mmap_log_chunk_size = 64 * 1024 * 1024;
+
+// The default maximum number of regions of a mmap_log.
+inline constexpr std::size_t mmap_log_max_chunks = 16 * 1024;
+
+// An append-only file written through memory mappings.
+//
+// The file is mapped in regions of chunk_size bytes. A region is mapped, and
+// the file extended, when the first write reaches it. Regions stay mapped
+// until the file is closed, so a writer never sees its region disappear.
+//
+// The space for a write is claimed with an atomic bump pointer, so multiple
+// threads can append concurrently. Every append is one contiguous block in
+// the file. On close the file is truncated to the written size.
+class mmap_log {
+public:
+  // Opens path for appending, the file is created when it does not exist.
+  //
+  // chunk_size is rounded up to a multiple of the page size.
+  explicit mmap_log(const char *path,
+                    std::size_t chunk_size = mmap_log_chunk_size,
+                    std::size_t max_chunks = mmap_log_max_chunks)
+      : chunk_size_(round_to_pages(chunk_size)), max_chunks_(max_chunks),
+        chunks_(std::make_unique<std::atomic<char *>[]>(max_chunks)) {
+    fd_ = ::open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd_ < 0)
+      throw_error("failed to open the log file");
+
+    struct stat status;
+    if (::fstat(fd_, &status) != 0) {
+      ::close(fd_);
+      throw_error("failed to query the size of the log file");
+    }
+    file_size_ = status.st_size;
+    offset_.store(file_size_, std::memory_order_relaxed);
+  }
+
+  ~mmap_log() {
+    try {
+      close();
+    } catch (...) {
+    }
+  }
+
+  mmap_log(const mmap_log &) = delete;
+  mmap_log &operator=(const mmap_log &) = delete;
+
+  // Appends data as one contiguous block.
+  //
+  // This function is thread-safe.
+  void append(std::string_view data) {
+    std::size_t offset =
+        offset_.fetch_add(data.size(), std::memory_order_relaxed);
+    while (!data.empty()) {
+      std::size_t index = offset % chunk_size_;
+      std::size_t size = std::min(data.size(), chunk_size_ - index);
+      std::memcpy(chunk(offset / chunk_size_) + index, data.data(), size);
+      data.remove_prefix(size);
+      offset += size;
+    }
+  }
+
+  // Appends data as one contiguous block, this makes mmap_log a sink.
+  //
+  // ctf::format_to<fmt>(log, args...) appends its whole output as one block,
+  // the sink interface is used by other code writing to a sink.
+  void write(std::span<const char> data) {
+    append({data.data(), data.size()});
+  }
+
+  // Returns the size of the file when all pending appends are done.
+  std::size_t size() const noexcept {
+    return offset_.load(std::memory_order_relaxed);
+  }
+
+  // Unmaps the file and truncates it to its written size.
+  //
+  // No append may be in progress.
+  void close() {
+    if (fd_ < 0)
+      return;
+
+    for (std::size_t i = 0; i != max_chunks_; ++i)
+      if (char *address = chunks_[i].exchange(nullptr))
+        ::munmap(address, chunk_size_);
+
+    int fd = std::exchange(fd_, -1);
+    bool truncated = ::ftruncate(fd, size()) == 0;
+    int error = errno;
+    ::close(fd);
+    if (!truncated) {
+      errno = error;
+      throw_error("failed to truncate the log file");
+    }
+  }
+
+private:
+  [[noreturn]] static void throw_error(const char *message) {
+    throw std::system_error(errno, std::generic_category(), message);
+  }
+
+  static std::size_t round_to_pages(std::size_t size) {
+    std::size_t page = ::sysconf(_SC_PAGESIZE);
+    return std::max(page, (size + page - 1) / page * page);
+  }
+
+  char *chunk(std::size_t index) {
+    if (index >= max_chunks_) [[unlikely]]
+      throw std::length_error("the log file exceeds its maximum size");
+
+    char *result = chunks_[index].load(std::memory_order_acquire);
+    if (result == nullptr) [[unlikely]]
+      result = map(index);
+    return result;
+  }
+
+  char *map(std::size_t index) {
+    std::lock_guard lock{mutex_};
+    if (char *result = chunks_[index].load(std::memory_order_relaxed))
+      return result;
+
+    std::size_t end = (index + 1) * chunk_size_;
+    if (file_size_ < end) {
+      if (::ftruncate(fd_, end) != 0)
+        throw_error("failed to extend the log file");
+      file_size_ = end;
+    }
+
+    void *result = ::mmap(nullptr, chunk_size_, PROT_READ | PROT_WRITE,
+                          MAP_SHARED, fd_, index * chunk_size_);
+    if (result == MAP_FAILED)
+      throw_error("failed to map the log file");
+
+    chunks_[index].store(static_cast<char *>(result),
+                         std::memory_order_release);
+    return static_cast<char *>(result);
+  }
+
+  int fd_;
+  std::size_t chunk_size_;
+  std::size_t max_chunks_;
+  std::unique_ptr<std::atomic<char *>[]> chunks_;
+  std::atomic<std::size_t> offset_;
+
+  // Protects mapping a new chunk and extending the file.
+  std::mutex mutex_;
+  std::size_t file_size_;
+};
+
+// The largest upper limit of the output formatted in a buffer of that size.
+inline constexpr std::size_t mmap_log_stack_size = 1024;
+
+// Appends the output to log as one contiguous block.
+//
+// The output is formatted on the stack and then copied in the mapped file, so
+// every line is written once in the page cache and the space claimed in the
+// file has the exact size. Output with a small upper limit is written directly
+// in a buffer of that size, other output in a scratch_buffer.
+template <fixed_string fmt, class... Args>
+  requires std::same_as<typename decltype(fmt)::char_type, char>
+void format_to(mmap_log &log, Args &&...args) {
+  constexpr auto status = parse<fmt, Args...>();
+
+  if constexpr (ctf::is_format_error(status))
+    static_assert(!"parse error", status);
+  else {
+    constexpr max_size_result bound = ctf::max_size<fmt>(status.tokens);
+    if constexpr (bound.size <= mmap_log_stack_size) {
+      std::array<char, bound.size> buffer;
+      char *last =
+          ctf::format_tokens_to<fmt>(buffer.data(), status.tokens, args...);
+      log.append({buffer.data(), last});
+    } else {
+      scratch_buffer<mmap_log_stack_size> buffer;
+      ctf::format_tokens_to<fmt>(std::back_inserter(buffer), status.tokens,
+                                 args...);
+      log.append(buffer.view());
+    }
+  }
+}
+
+} // namespace ctf
+
+#endif // CTF_MMAP_LOG_HPP
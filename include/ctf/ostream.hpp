@@ -0,0 +1,111 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CTF_OSTREAM_HPP
+#define CTF_OSTREAM_HPP
+
+#include "format.hpp"
+#include "sink.hpp"
+#include "utility.hpp"
+
+#include <algorithm>
+#include <ios>
+#include <ostream>
+#include <span>
+#include <streambuf>
+
+namespace ctf {
+
+namespace detail {
+
+// Gives access to the put area of a stream buffer.
+//
+// The put area members are protected, a pointer to the member obtained in a
+// derived class can be used on every stream buffer.
+template <class CharT>
+struct streambuf_access : std::basic_streambuf<CharT> {
+  using base = std::basic_streambuf<CharT>;
+
+  static CharT *next(base &buffer) {
+    return (buffer.*&streambuf_access::pptr)();
+  }
+  static CharT *end(base &buffer) {
+    return (buffer.*&streambuf_access::epptr)();
+  }
+  static void bump(base &buffer, int n) {
+    (buffer.*&streambuf_access::pbump)(n);
+  }
+};
+
+} // namespace detail
+
+// Writes the output to a stream buffer.
+//
+// Output that fits in the put area is copied directly, otherwise it is
+// written with sputn, which calls overflow when the put area is exhausted.
+// After a failed write the remaining output is discarded.
+template <class CharT> class streambuf_sink {
+public:
+  explicit streambuf_sink(std::basic_streambuf<CharT> &buffer) noexcept
+      : buffer_(&buffer) {}
+
+  void write(std::span<const CharT> data) {
+    if (failed_)
+      return;
+
+    using access = detail::streambuf_access<CharT>;
+    CharT *next = access::next(*buffer_);
+    if (static_cast<std::size_t>(access::end(*buffer_) - next) >=
+        data.size()) {
+      std::copy_n(data.data(), data.size(), next);
+      access::bump(*buffer_, static_cast<int>(data.size()));
+    } else
+      failed_ = buffer_->sputn(data.data(), data.size()) !=
+                static_cast<std::streamsize>(data.size());
+  }
+
+  bool failed() const noexcept { return failed_; }
+
+private:
+  std::basic_streambuf<CharT> *buffer_;
+  bool failed_{false};
+};
+
+// Writes the output to the stream buffer of os.
+//
+// Like the formatted output functions of the stream, failing to write the
+// output sets badbit.
+template <fixed_string fmt, class... Args>
+void format_to(std::basic_ostream<typename decltype(fmt)::char_type> &os,
+               Args &&...args) {
+  using CharT = typename decltype(fmt)::char_type;
+
+  typename std::basic_ostream<CharT>::sentry sentry{os};
+  if (!sentry)
+    return;
+
+  bool failed;
+  try {
+    streambuf_sink<CharT> sink{*os.rdbuf()};
+    ctf::format_to<fmt>(sink, args...);
+    failed = sink.failed();
+  } catch (...) {
+    try {
+      os.setstate(std::ios_base::badbit);
+    } catch (...) {
+    }
+    if (os.exceptions() & std::ios_base::badbit)
+      throw;
+    return;
+  }
+  if (failed)
+    os.setstate(std::ios_base::badbit);
+}
+
+} // namespace ctf
+
+#endif // CTF_OSTREAM_HPP
@@ -0,0 +1,165 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CTF_PRINT_HPP
+#define CTF_PRINT_HPP
+
+#include "format.hpp"
+#include "sink.hpp"
+#include "utility.hpp"
+
+#include <cerrno>
+#include <concepts>
+#include <cstddef>
+#include <cstdio>
+#include <iterator>
+#include <string_view>
+#include <system_error>
+
+namespace ctf {
+
+// The size of the stack buffer used by the print functions.
+//
+// Output that fits in the buffer is written with one call to fwrite or write.
+// Larger output is written in chunks of this size.
+inline constexpr std::size_t print_buffer_size = 4096;
+
+namespace detail {
+
+// The buffer for the output of the print functions.
+//
+// The class models the container requirements of std::back_insert_iterator.
+// When the buffer is full its contents are passed to the Write function.
+template <class Write> class print_buffer {
+public:
+  using value_type = char;
+
+  explicit print_buffer(Write write) : write_(write) {}
+
+  print_buffer(const print_buffer &) = delete;
+  print_buffer &operator=(const print_buffer &) = delete;
+
+  void push_back(char c) {
+    if (size_ == print_buffer_size) [[unlikely]]
+      flush();
+    data_[size_++] = c;
+  }
+
+  void flush() {
+    write_(std::string_view{data_, size_});
+    size_ = 0;
+  }
+
+private:
+  char data_[print_buffer_size];
+  std::size_t size_{0};
+  Write write_;
+};
+
+template <fixed_string fmt, bool newline, class Write, class... Args>
+  requires std::same_as<typename decltype(fmt)::char_type, char>
+void print(Write write, Args &...args) {
+  constexpr auto status = parse<fmt, Args...>();
+
+  if constexpr (ctf::is_format_error(status))
+    static_assert(!"parse error", status);
+  else {
+    print_buffer buffer{write};
+    ctf::format_tokens_to<fmt>(std::back_inserter(buffer), status.tokens,
+                               args...);
+    if constexpr (newline)
+      buffer.push_back('\n');
+    buffer.flush();
+  }
+}
+
+[[noreturn]] inline void throw_print_error() {
+  throw std::system_error(errno, std::generic_category(),
+                          "failed to write the formatted output");
+}
+
+// Holds the lock of a FILE.
+//
+// The lock is recursive, so the stdio functions can still be used. This keeps
+// the chunks of a large output together.
+class file_lock {
+public:
+  explicit file_lock(std::FILE *stream) : stream_(stream) {
+    flockfile(stream_);
+  }
+  ~file_lock() { funlockfile(stream_); }
+
+  file_lock(const file_lock &) = delete;
+  file_lock &operator=(const file_lock &) = delete;
+
+private:
+  std::FILE *stream_;
+};
+
+template <fixed_string fmt, bool newline, class... Args>
+void print_file(std::FILE *stream, Args &...args) {
+  file_lock lock{stream};
+  detail::print<fmt, newline>(
+      [stream](std::string_view output) {
+        if (std::fwrite(output.data(), 1, output.size(), stream) !=
+            output.size())
+          detail::throw_print_error();
+      },
+      args...);
+}
+
+template <fixed_string fmt, bool newline, class... Args>
+void print_fd(int fd, Args &...args) {
+  detail::print<fmt, newline>(
+      [fd](std::string_view output) { detail::write_fd(fd, output); },
+      args...);
+}
+
+} // namespace detail
+
+// Writes the formatted output to stream.
+//
+// The stream is locked during the call, so the output of concurrent calls is
+// not interleaved.
+template <fixed_string fmt, class... Args>
+void print(std::FILE *stream, Args &&...args) {
+  detail::print_file<fmt, false>(stream, args...);
+}
+
+template <fixed_string fmt, class... Args> void print(Args &&...args) {
+  detail::print_file<fmt, false>(stdout, args...);
+}
+
+// Writes the formatted output followed by a new line to stream.
+template <fixed_string fmt, class... Args>
+void println(std::FILE *stream, Args &&...args) {
+  detail::print_file<fmt, true>(stream, args...);
+}
+
+template <fixed_string fmt, class... Args> void println(Args &&...args) {
+  detail::print_file<fmt, true>(stdout, args...);
+}
+
+// Writes the formatted output to the file descriptor fd.
+//
+// Output that fits in print_buffer_size is written with one call to write. So
+// concurrent writes to a pipe or a file opened with O_APPEND are not
+// interleaved. Larger output is written in multiple calls.
+template <fixed_string fmt, class... Args>
+void print_fd(int fd, Args &&...args) {
+  detail::print_fd<fmt, false>(fd, args...);
+}
+
+// Writes the formatted output followed by a new line to the file descriptor.
+template <fixed_string fmt, class... Args>
+void println_fd(int fd, Args &&...args) {
+  detail::print_fd<fmt, true>(fd, args...);
+}
+
+} // namespace ctf
+
+#endif // CTF_PRINT_HPP
@@ -0,0 +1,362 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CTF_PRINTF_FORMAT_HPP
+#define CTF_PRINTF_FORMAT_HPP
+
+#include "format.hpp"
+#include "format_error.hpp"
+#include "utility.hpp"
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+// printf-style format strings.
+//
+// The printf format string is translated at compile-time to a format string
+// for ctf::format. The conversions are validated against the argument types,
+// so the output is produced by the same tokens as ctf::format.
+namespace ctf {
+
+namespace detail {
+
+// The category of an argument for the printf conversions.
+enum class printf_kind {
+  integer,
+  boolean,
+  character,
+  floating,
+  string,
+  // A pointer to a string, valid for %s and %p.
+  string_pointer,
+  pointer,
+  other
+};
+
+template <class T> consteval printf_kind printf_kind_of() {
+  using U = std::remove_cvref_t<T>;
+  if constexpr (std::same_as<U, bool>)
+    return printf_kind::boolean;
+  else if constexpr (std::same_as<U, char>)
+    return printf_kind::character;
+  else if constexpr (std::integral<U>)
+    return printf_kind::integer;
+  else if constexpr (std::floating_point<U>)
+    return printf_kind::floating;
+  else if constexpr (std::convertible_to<const U &, std::string_view>)
+    return std::is_pointer_v<U> || std::is_array_v<U>
+               ? printf_kind::string_pointer
+               : printf_kind::string;
+  else if constexpr (std::is_pointer_v<U> || std::same_as<U, nullptr_t>)
+    return printf_kind::pointer;
+  else
+    return printf_kind::other;
+}
+
+template <class... Args> consteval auto printf_kinds() {
+  return std::array<printf_kind, sizeof...(Args)>{printf_kind_of<Args>()...};
+}
+
+template <std::size_t N> struct printf_translation {
+  // The format string for ctf::format.
+  std::string fmt;
+  // The conversion used for every argument, '*' for a width or precision.
+  std::array<char, N> conversions{};
+  // Whether the conversion of the argument is %#x or %#X.
+  std::array<bool, N> alternate_hex{};
+
+  // The error message and the offsets of the conversion containing the error.
+  std::string error;
+  std::size_t begin = 0;
+  std::size_t end = 0;
+};
+
+consteval bool is_digit(char c) { return c >= '0' && c <= '9'; }
+
+// Translates the printf format string fmt for arguments of kinds.
+//
+// Every replacement-field uses an explicit arg-id, since the argument of a
+// '*' width or precision precedes the value.
+template <fixed_string fmt, std::size_t N>
+consteval printf_translation<N>
+translate_printf(std::array<printf_kind, N> kinds) {
+  printf_translation<N> result;
+  std::size_t arg = 0;
+
+  auto fail = [&](std::string message, std::size_t begin, std::size_t end) {
+    result.error = std::move(message);
+    result.begin = begin;
+    result.end = end;
+    return result;
+  };
+
+  for (std::size_t i = 0; i < fmt.size(); ++i) {
+    char c = fmt[i];
+    if (c == '{' || c == '}') {
+      result.fmt.append(2, c);
+      continue;
+    }
+    if (c != '%') {
+      result.fmt.push_back(c);
+      continue;
+    }
+
+    std::size_t begin = i++;
+    if (fmt[i] == '%') {
+      result.fmt.push_back('%');
+      continue;
+    }
+
+    bool left = false, plus = false, space = false, alternate = false,
+         zero = false;
+    for (;; ++i) {
+      if (fmt[i] == '-')
+        left = true;
+      else if (fmt[i] == '+')
+        plus = true;
+      else if (fmt[i] == ' ')
+        space = true;
+      else if (fmt[i] == '#')
+        alternate = true;
+      else if (fmt[i] == '0')
+        zero = true;
+      else
+        break;
+    }
+
+    // A '*' is stored as an empty string, the argument is taken later.
+    std::string width;
+    bool has_width = false;
+    bool dynamic_width = false;
+    if (fmt[i] == '*') {
+      has_width = dynamic_width = true;
+      ++i;
+    } else
+      for (; is_digit(fmt[i]); ++i) {
+        has_width = true;
+        width.push_back(fmt[i]);
+      }
+
+    std::string precision;
+    bool has_precision = false;
+    bool dynamic_precision = false;
+    if (fmt[i] == '.') {
+      has_precision = true;
+      if (fmt[++i] == '*') {
+        dynamic_precision = true;
+        ++i;
+      } else {
+        for (; is_digit(fmt[i]); ++i)
+          precision.push_back(fmt[i]);
+        if (precision.empty())
+          precision = "0";
+      }
+    }
+
+    // The length modifiers are not needed, the types of the arguments are
+    // known.
+    while (std::string_view{"hljztL"}.contains(fmt[i]))
+      ++i;
+
+    if (i >= fmt.size())
+      return fail("incomplete conversion specification", begin, i);
+
+    char conversion = fmt[i];
+    bool integer = std::string_view{"diuoxX"}.contains(conversion);
+    bool floating = std::string_view{"eEfFgGaA"}.contains(conversion);
+    if (conversion == 'n')
+      return fail("the %n conversion is not supported", begin, i);
+    if (!integer && !floating && !std::string_view{"csp"}.contains(conversion))
+      return fail("unknown conversion specifier", begin, i);
+    if (has_precision && !floating && conversion != 's')
+      return fail("a precision is only supported for floating-point and string "
+                  "conversions",
+                  begin, i);
+
+    // Returns the arg-id of the next argument.
+    auto take_argument = [&](char c) {
+      result.conversions[arg] = c;
+      return arg++;
+    };
+
+    if (dynamic_width) {
+      if (arg == N)
+        return fail("missing argument for the width", begin, i);
+      if (kinds[arg] != printf_kind::integer)
+        return fail("the argument for the width needs to be an integer", begin,
+                    i);
+      width = '{' + ctf::to_string(take_argument('*')) + '}';
+    }
+    if (dynamic_precision) {
+      if (arg == N)
+        return fail("missing argument for the precision", begin, i);
+      if (kinds[arg] != printf_kind::integer)
+        return fail("the argument for the precision needs to be an integer",
+                    begin, i);
+      precision = '{' + ctf::to_string(take_argument('*')) + '}';
+    }
+
+    if (arg == N)
+      return fail("missing argument for the conversion", begin, i);
+    printf_kind kind = kinds[arg];
+    if (integer && kind != printf_kind::integer &&
+        kind != printf_kind::boolean && kind != printf_kind::character)
+      return fail("the argument for the conversion needs to be an integer",
+                  begin, i);
+    if (floating && kind != printf_kind::floating)
+      return fail(
+          "the argument for the conversion needs to be a floating-point value",
+          begin, i);
+    if (conversion == 'c' && kind != printf_kind::integer &&
+        kind != printf_kind::character)
+      return fail("the argument for the conversion needs to be a character",
+                  begin, i);
+    if (conversion == 's' && kind != printf_kind::string &&
+        kind != printf_kind::string_pointer)
+      return fail("the argument for the conversion needs to be a string", begin,
+                  i);
+    if (conversion == 'p' && kind != printf_kind::pointer &&
+        kind != printf_kind::string_pointer)
+      return fail("the argument for the conversion needs to be a pointer",
+                  begin, i);
+
+    result.alternate_hex[arg] =
+        alternate && (conversion == 'x' || conversion == 'X');
+
+    result.fmt += '{' + ctf::to_string(take_argument(conversion)) + ':';
+    // Unlike printf std::format left aligns strings by default.
+    bool zero_padding = zero && !left && (integer || floating);
+    if (left)
+      result.fmt.push_back('<');
+    else if (has_width && !zero_padding)
+      result.fmt.push_back('>');
+    if (std::string_view{"dieEfFgGaA"}.contains(conversion)) {
+      if (plus)
+        result.fmt.push_back('+');
+      else if (space)
+        result.fmt.push_back(' ');
+    }
+    if (alternate && std::string_view{"oxXeEfFgGaA"}.contains(conversion))
+      result.fmt.push_back('#');
+    if (zero_padding)
+      result.fmt.push_back('0');
+    result.fmt += width;
+    if (has_precision)
+      result.fmt += '.' + precision;
+    result.fmt.push_back(conversion == 'i' || conversion == 'u' ? 'd'
+                                                                : conversion);
+    result.fmt.push_back('}');
+  }
+
+  if (arg != N)
+    return fail("too many arguments for the format string", 0, fmt.size());
+  return result;
+}
+
+// Returns the format string for ctf::format or a format_error.
+template <fixed_string fmt, class... Args> consteval auto printf_translate() {
+  constexpr auto kinds = detail::printf_kinds<Args...>();
+  if constexpr (!detail::translate_printf<fmt>(kinds).error.empty()) {
+    auto result = detail::translate_printf<fmt>(kinds);
+    return ctf::create_format_error(std::move(result.error), fmt, result.begin,
+                                    result.begin, result.end);
+  } else {
+    constexpr std::size_t size =
+        detail::translate_printf<fmt>(kinds).fmt.size();
+    auto result = detail::translate_printf<fmt>(kinds);
+    char buffer[size + 1];
+    std::ranges::copy(result.fmt, buffer);
+    buffer[size] = '\0';
+    return fixed_string<char, size + 1>{buffer};
+  }
+}
+
+// An integer written by %#x or %#X.
+//
+// Unlike std::format printf writes no 0x prefix for zero.
+template <class T> struct printf_alternate_hex {
+  T value;
+};
+
+// Converts an argument to the type used by the printf conversion c.
+template <char c, bool alternate_hex, class T>
+constexpr decltype(auto) printf_arg(T &&arg) {
+  using U = std::remove_cvref_t<T>;
+  if constexpr (c == 'p')
+    return static_cast<const void *>(arg);
+  else if constexpr (alternate_hex) {
+    using V = std::remove_cvref_t<decltype(detail::printf_arg<c, false>(arg))>;
+    return printf_alternate_hex<V>{detail::printf_arg<c, false>(arg)};
+  }
+  else if constexpr (std::string_view{"uoxX"}.contains(c) &&
+                     std::signed_integral<U>)
+    // Like printf a negative value is shown as its two's complement.
+    return static_cast<std::make_unsigned_t<U>>(arg);
+  else
+    return std::forward<T>(arg);
+}
+
+} // namespace detail
+
+template <fixed_string fmt, class... Args>
+concept printf_valid =
+    !ctf::is_format_error(detail::printf_translate<fmt, Args...>());
+
+// Formats the arguments using a printf format string.
+//
+// The conversions are validated at compile-time. The output matches
+// snprintf, with these differences:
+// - the length modifiers are ignored, the type of the argument is used,
+// - the precision is only supported for floating-point and string
+//   conversions,
+// - a negative width argument is an error instead of left alignment, and
+// - %a does not write the 0x prefix.
+template <fixed_string fmt, class... Args>
+  requires std::same_as<typename decltype(fmt)::char_type, char>
+std::string printf_format(Args &&...args) {
+  constexpr auto translated = detail::printf_translate<fmt, Args...>();
+
+  if constexpr (ctf::is_format_error(translated))
+    static_assert(!"parse error", translated);
+  else {
+    constexpr auto translation =
+        detail::translate_printf<fmt>(detail::printf_kinds<Args...>());
+    constexpr auto conversions = translation.conversions;
+    constexpr auto alternate_hex = translation.alternate_hex;
+    return [&]<std::size_t... I>(std::index_sequence<I...>) {
+      return ctf::format<translated>(
+          detail::printf_arg<conversions[I], alternate_hex[I]>(
+              std::forward<Args>(args))...);
+    }(std::index_sequence_for<Args...>());
+  }
+}
+
+} // namespace ctf
+
+// Writes the value without the alternate form when it is zero.
+template <class T>
+struct std::formatter<ctf::detail::printf_alternate_hex<T>, char>
+    : std::formatter<T, char> {
+  template <class FormatContext>
+  typename FormatContext::iterator
+  format(ctf::detail::printf_alternate_hex<T> value, FormatContext &ctx) const {
+    if (value.value != T(0))
+      return std::formatter<T, char>::format(value.value, ctx);
+
+    std::formatter<T, char> formatter = *this;
+    formatter.__parser_.__alternate_form_ = false;
+    return formatter.format(value.value, ctx);
+  }
+};
+
+#endif // CTF_PRINTF_FORMAT_HPP
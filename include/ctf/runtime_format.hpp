@@ -0,0 +1,283 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CTF_RUNTIME_FORMAT_HPP
+#define CTF_RUNTIME_FORMAT_HPP
+
+#include "format.hpp"
+#include "sink.hpp"
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <deque>
+#include <format>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace ctf {
+
+// The maximum number of plans cached for every list of argument types.
+inline constexpr std::size_t runtime_format_cache_size = 256;
+
+namespace detail {
+
+// A format string parsed at run-time for the argument types Args.
+//
+// The plan contains the same tokens as the compile-time parser: the literal
+// text and the replacement-fields with their parsed formatters. Like
+// std::vformat invalid format strings throw a std::format_error.
+template <class... Args> class runtime_plan {
+public:
+  // The formatter of every argument, the monostate is used for literal text.
+  using formatter = std::variant<
+      std::monostate,
+      std::formatter<std::remove_cvref_t<format_arg_t<char, Args>>, char>...>;
+
+  // The stored arguments, these are the same as for ctf::format.
+  using arguments = std::tuple<format_arg_value_t<char, const Args>...>;
+
+  explicit runtime_plan(std::string_view fmt) : fmt_(fmt) { parse(); }
+
+  runtime_plan(const runtime_plan &) = delete;
+  runtime_plan &operator=(const runtime_plan &) = delete;
+
+  std::string_view format_string() const noexcept { return fmt_; }
+
+  // The number of characters of literal text.
+  std::size_t literal_size() const noexcept { return literal_size_; }
+
+  // Writes the output to a sink or appends it to a std::string.
+  template <class S> void format_to(S &out, arguments &args) const {
+    for (const token &t : tokens_) {
+      if (t.index != text)
+        formatters<S>[t.index](t, args, out);
+      else if constexpr (std::same_as<S, std::string>)
+        out.append(&fmt_[t.offset], t.size);
+      else
+        out.write(std::span<const char>{&fmt_[t.offset], t.size});
+    }
+  }
+
+private:
+  static constexpr std::size_t text = std::numeric_limits<std::size_t>::max();
+
+  struct token {
+    // The literal text, or the replacement-field, at offset.
+    std::size_t offset;
+    std::size_t size;
+    // The index of the argument, or text for literal text.
+    std::size_t index;
+    formatter f;
+  };
+
+  template <std::size_t I>
+  static const char *parse_arg(token &t,
+                               std::basic_format_parse_context<char> &ctx) {
+    return t.f.template emplace<I + 1>().parse(ctx);
+  }
+
+  // The sink_iterator writes the output of a formatter one element at a time,
+  // a string is appended by push_back.
+  template <class S> static auto output(S &out) {
+    if constexpr (std::same_as<S, std::string>)
+      return std::back_inserter(out);
+    else
+      return sink_iterator<S, char>{out};
+  }
+
+  template <class S, std::size_t I>
+  static void format_arg(const token &t, arguments &args, S &out) {
+    ctf::format_replacement_field<char>(std::get<I + 1>(t.f),
+                                        std::get<I>(args), args, output(out));
+  }
+
+  template <class S>
+  static constexpr auto formatters =
+      []<std::size_t... I>(std::index_sequence<I...>) {
+        return std::array<void (*)(const token &, arguments &, S &),
+                          sizeof...(I)>{&format_arg<S, I>...};
+      }(std::index_sequence_for<Args...>());
+
+  void add_text(const char *first, const char *last) {
+    if (first == last)
+      return;
+    tokens_.push_back({std::size_t(first - fmt_.data()),
+                       std::size_t(last - first), text, {}});
+    literal_size_ += last - first;
+  }
+
+  void parse() {
+    std::basic_format_parse_context<char> ctx{fmt_, sizeof...(Args)};
+    const char *end = fmt_.data() + fmt_.size();
+    const char *first = fmt_.data();
+    for (const char *it = first; it != end;) {
+      if (*it == '{') {
+        if (it + 1 != end && it[1] == '{') {
+          add_text(first, it + 1);
+          first = it += 2;
+        } else {
+          add_text(first, it);
+          first = it = parse_replacement_field(ctx, it);
+        }
+      } else if (*it == '}') {
+        if (it + 1 == end || it[1] != '}')
+          throw std::format_error("expected '}' in escape sequence");
+        add_text(first, it + 1);
+        first = it += 2;
+      } else
+        ++it;
+    }
+    add_text(first, end);
+  }
+
+  // Parses the replacement-field starting at it.
+  //
+  // Returns the position after the replacement-field.
+  const char *
+  parse_replacement_field(std::basic_format_parse_context<char> &ctx,
+                          const char *it) {
+    const char *end = fmt_.data() + fmt_.size();
+    token t{std::size_t(it - fmt_.data()), 0, 0, {}};
+    if (++it == end)
+      throw std::format_error("unexpected end of the format string");
+
+    if (*it >= '0' && *it <= '9') {
+      if (*it == '0')
+        ++it;
+      else
+        for (; it != end && *it >= '0' && *it <= '9'; ++it)
+          t.index = std::min(t.index * 10 + (*it - '0'), sizeof...(Args));
+      ctx.check_arg_id(t.index);
+    } else
+      t.index = ctx.next_arg_id();
+
+    if (t.index >= sizeof...(Args))
+      throw std::format_error(
+          "the arg-id of the replacement-field is out of bounds");
+    if (it == end || (*it != ':' && *it != '}'))
+      throw std::format_error("unexpected character in the format string");
+    if (*it == ':')
+      ++it;
+
+    ctx.advance_to(it);
+    it = parsers[t.index](t, ctx);
+    if (it == end || *it != '}')
+      throw std::format_error(
+          "expected '}' at the end of the replacement-field");
+
+    t.size = it + 1 - (fmt_.data() + t.offset);
+    tokens_.push_back(std::move(t));
+    return it + 1;
+  }
+
+  static constexpr auto parsers =
+      []<std::size_t... I>(std::index_sequence<I...>) {
+        return std::array<const char *(*)(token &,
+                                          std::basic_format_parse_context<
+                                              char> &),
+                          sizeof...(I)>{&parse_arg<I>...};
+      }(std::index_sequence_for<Args...>());
+
+  std::string fmt_;
+  std::vector<token> tokens_;
+  std::size_t literal_size_{0};
+};
+
+// A bounded cache of plans.
+//
+// Lookups take a shared lock, so threads using cached plans do not block each
+// other. When the cache is full the oldest plan is removed. A removed plan
+// remains valid while it is used.
+template <class Plan> class plan_cache {
+public:
+  std::shared_ptr<const Plan> get(std::string_view fmt) {
+    {
+      std::shared_lock lock{mutex_};
+      if (auto it = plans_.find(fmt); it != plans_.end())
+        return it->second;
+    }
+
+    // Parse outside the lock, invalid format strings are not stored.
+    auto plan = std::make_shared<const Plan>(fmt);
+
+    std::unique_lock lock{mutex_};
+    auto [it, inserted] = plans_.try_emplace(plan->format_string(), plan);
+    if (inserted) {
+      order_.push_back(it->first);
+      if (order_.size() > runtime_format_cache_size) {
+        plans_.erase(order_.front());
+        order_.pop_front();
+      }
+    }
+    return it->second;
+  }
+
+private:
+  std::shared_mutex mutex_;
+  // The keys refer to the format string in the plan.
+  std::unordered_map<std::string_view, std::shared_ptr<const Plan>> plans_;
+  std::deque<std::string_view> order_;
+};
+
+template <class... Args> plan_cache<runtime_plan<Args...>> &runtime_cache() {
+  static plan_cache<runtime_plan<Args...>> result;
+  return result;
+}
+
+// Writes the output to the sink or appends it to the std::string out.
+template <class S, class... Args>
+void runtime_format_to(S &out, std::string_view fmt, Args &&...args) {
+  using plan = runtime_plan<std::remove_cvref_t<Args>...>;
+  static_assert(
+      (std::formattable<std::remove_cvref_t<format_arg_t<char, Args>>, char> &&
+       ...),
+      "the arguments need to be formattable");
+
+  std::shared_ptr<const plan> p =
+      detail::runtime_cache<std::remove_cvref_t<Args>...>().get(fmt);
+  typename plan::arguments t{ctf::as_format_arg<char>(std::as_const(args))...};
+  detail::sink_reserve(out, p->literal_size());
+  p->format_to(out, t);
+}
+
+} // namespace detail
+
+// Writes the output of a format string known at run-time to the sink.
+//
+// The format string is parsed once for every list of argument types, the
+// parsed plans are cached. Throws std::format_error when the format string is
+// invalid.
+template <sink S, class... Args>
+void runtime_format_to(S &sink, std::string_view fmt, Args &&...args) {
+  detail::runtime_format_to(sink, fmt, args...);
+}
+
+// Formats the arguments using a format string known at run-time.
+template <class... Args>
+std::string runtime_format(std::string_view fmt, Args &&...args) {
+  std::string result;
+  detail::runtime_format_to(result, fmt, args...);
+  return result;
+}
+
+} // namespace ctf
+
+#endif // CTF_RUNTIME_FORMAT_HPP
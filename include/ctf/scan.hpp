@@ -0,0 +1,244 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CTF_SCAN_HPP
+#define CTF_SCAN_HPP
+
+// This uses libc++'s implementation details to inspect the parsed formatters.
+#include <version>
+#ifndef _LIBCPP_VERSION
+#error This header requires libc++'s format implementation
+#endif
+
+#include "format.hpp"
+#include "tuple.hpp"
+#include "utility.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <concepts>
+#include <cstddef>
+#include <expected>
+#include <format>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <tuple>
+#include <type_traits>
+
+namespace ctf {
+
+enum class scan_errc {
+  // The input does not match the literal text of the format string.
+  literal_mismatch,
+  // The input does not contain a value of the type of the argument.
+  invalid_value,
+  // The value does not fit in the type of the argument.
+  value_out_of_range,
+  // The input contains characters after the end of the format string.
+  trailing_input
+};
+
+struct scan_error {
+  scan_errc code;
+  // The offset in the input where the error occurred.
+  std::size_t position;
+};
+
+namespace detail {
+
+// The types that can be scanned.
+//
+// A std::string_view refers to the input.
+template <class T>
+concept scannable = std::integral<T> || std::floating_point<T> ||
+                    std::same_as<T, std::string_view> ||
+                    std::same_as<T, std::string>;
+
+// The literal text following a replacement-field.
+//
+// A string extends up to this text, the last field up to the end of the
+// input.
+template <fixed_string fmt, class Tokens, std::size_t I>
+constexpr std::string_view scan_delimiter() {
+  if constexpr (I + 1 == ctf::tuple_size<Tokens>)
+    return {};
+  else {
+    using T = ctf::tuple_type<I + 1, Tokens>;
+    if constexpr (std::same_as<typename T::tag, output_char_tag>)
+      return {&fmt[T::offset], 1};
+    else if constexpr (std::same_as<typename T::tag, output_text_tag>)
+      return {&fmt[T::offset], T::size};
+    else
+      static_assert(false, "a string field needs to be followed by literal "
+                           "text or be the last replacement-field");
+  }
+}
+
+template <class T>
+std::expected<const char *, scan_errc>
+scan_from_chars(const char *first, const char *last, T &value, auto... args) {
+  auto [ptr, ec] = std::from_chars(first, last, value, args...);
+  if (ec == std::errc::invalid_argument)
+    return std::unexpected{scan_errc::invalid_value};
+  if (ec == std::errc::result_out_of_range)
+    return std::unexpected{scan_errc::value_out_of_range};
+  return ptr;
+}
+
+// Scans one value from the input.
+//
+// Returns the position after the value.
+template <class T, std::__format_spec::__type type>
+std::expected<const char *, scan_errc>
+scan_value(T &value, const char *first, const char *last,
+           std::string_view delimiter) {
+  using enum std::__format_spec::__type;
+  if constexpr (std::same_as<T, bool>) {
+    std::string_view input{first, last};
+    if (input.starts_with("true")) {
+      value = true;
+      return first + 4;
+    }
+    if (input.starts_with("false")) {
+      value = false;
+      return first + 5;
+    }
+    return std::unexpected{scan_errc::invalid_value};
+
+  } else if constexpr (std::same_as<T, char> &&
+                       (type == __default || type == __char)) {
+    if (first == last)
+      return std::unexpected{scan_errc::invalid_value};
+    value = *first;
+    return first + 1;
+
+  } else if constexpr (std::integral<T>) {
+    constexpr int base = type == __binary_lower_case ||
+                                 type == __binary_upper_case
+                             ? 2
+                         : type == __octal ? 8
+                         : type == __hexadecimal_lower_case ||
+                                 type == __hexadecimal_upper_case
+                             ? 16
+                             : 10;
+    return detail::scan_from_chars(first, last, value, base);
+
+  } else if constexpr (std::floating_point<T>) {
+    constexpr std::chars_format format =
+        type == __scientific_lower_case || type == __scientific_upper_case
+            ? std::chars_format::scientific
+        : type == __fixed_lower_case || type == __fixed_upper_case
+            ? std::chars_format::fixed
+        : type == __hexfloat_lower_case || type == __hexfloat_upper_case
+            ? std::chars_format::hex
+            : std::chars_format::general;
+    return detail::scan_from_chars(first, last, value, format);
+
+  } else {
+    const char *end = last;
+    if (!delimiter.empty())
+      end = std::ranges::search(first, last, delimiter.begin(),
+                                delimiter.end())
+                .begin();
+    value = T(first, end);
+    return end;
+  }
+}
+
+template <fixed_string fmt, class... Args>
+std::expected<std::tuple<Args...>, scan_error>
+scan_tokens(std::string_view input) {
+  static constexpr auto status = parse<fmt, Args...>();
+  using Tokens = decltype(status.tokens);
+
+  std::tuple<Args...> result{};
+  const char *first = input.data();
+  const char *last = input.data() + input.size();
+  std::optional<scan_error> error;
+
+  std::__for_each_index_sequence(
+      std::make_index_sequence<ctf::tuple_size<Tokens>>(), [&]<std::size_t I> {
+        if (error)
+          return;
+
+        using T = ctf::tuple_type<I, Tokens>;
+        if constexpr (std::same_as<typename T::tag, output_char_tag>) {
+          if (first == last || *first != fmt[T::offset])
+            error = scan_error{scan_errc::literal_mismatch,
+                               std::size_t(first - input.data())};
+          else
+            ++first;
+        } else if constexpr (std::same_as<typename T::tag, output_text_tag>) {
+          if (std::size_t(last - first) < T::size ||
+              std::char_traits<char>::compare(first, &fmt[T::offset],
+                                              T::size) != 0)
+            error = scan_error{scan_errc::literal_mismatch,
+                               std::size_t(first - input.data())};
+          else
+            first += T::size;
+        } else if constexpr (std::same_as<typename T::tag,
+                                        output_replacement_field_tag>) {
+          using A = std::tuple_element_t<T::index, std::tuple<Args...>>;
+          constexpr const auto &formatter =
+              status.tokens.template get<T>().formatter;
+          static_assert(requires { formatter.__parser_.__type_; },
+                        "the display type can't be scanned");
+          constexpr auto type = formatter.__parser_.__type_;
+          constexpr std::string_view delimiter = [] {
+            if constexpr (std::integral<A> || std::floating_point<A>)
+              return std::string_view{};
+            else
+              return detail::scan_delimiter<fmt, Tokens, I>();
+          }();
+
+          auto value = detail::scan_value<A, type>(
+              std::get<T::index>(result), first, last, delimiter);
+          if (value)
+            first = *value;
+          else
+            error = scan_error{value.error(),
+                               std::size_t(first - input.data())};
+        } else
+          static_assert(false, "type not supported");
+      });
+
+  if (error)
+    return std::unexpected{*error};
+  if (first != last)
+    return std::unexpected{scan_error{scan_errc::trailing_input,
+                                      std::size_t(first - input.data())}};
+  return result;
+}
+
+} // namespace detail
+
+// Scans the values of the arguments from the input.
+//
+// The format string is parsed like for ctf::format, the type of the
+// format-spec selects the representation of the value, other options are
+// ignored. A bool is scanned as true or false. The literal text needs to match
+// the input exactly. A string argument extends up to the literal text
+// following it. The complete input needs to be matched.
+template <fixed_string fmt, class... Args>
+  requires std::same_as<typename decltype(fmt)::char_type, char>
+std::expected<std::tuple<Args...>, scan_error> scan(std::string_view input) {
+  static_assert((detail::scannable<Args> && ...),
+                "the arguments need to be arithmetic types or strings");
+
+  constexpr auto status = parse<fmt, Args...>();
+
+  if constexpr (ctf::is_format_error(status))
+    static_assert(!"parse error", status);
+  else
+    return detail::scan_tokens<fmt, Args...>(input);
+}
+
+} // namespace ctf
+
+#endif // CTF_SCAN_HPP
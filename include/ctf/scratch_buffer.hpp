@@ -0,0 +1,85 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CTF_SCRATCH_BUFFER_HPP
+#define CTF_SCRATCH_BUFFER_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace ctf {
+
+// The default size of the stack buffer of a scratch_buffer.
+inline constexpr std::size_t scratch_buffer_size = 256;
+
+// A temporary buffer for formatted output.
+//
+// The output is stored in a buffer inside the object. When that buffer is
+// full the output is moved to the heap. This allows creating the final result
+// once the size of the output is known. This avoids the unused capacity the
+// geometric growth of a std::string leaves behind.
+//
+// The class models the container requirements of std::back_insert_iterator.
+template <std::size_t N = scratch_buffer_size> class scratch_buffer {
+public:
+  using value_type = char;
+
+  constexpr scratch_buffer() noexcept = default;
+
+  scratch_buffer(const scratch_buffer &) = delete;
+  scratch_buffer &operator=(const scratch_buffer &) = delete;
+
+  constexpr void push_back(char c) {
+    if (size_ < N) [[likely]]
+      stack_[size_++] = c;
+    else
+      spill(&c, 1);
+  }
+
+  constexpr void append(const char *data, std::size_t size) {
+    if (size_ + size <= N) [[likely]] {
+      std::copy_n(data, size, &stack_[size_]);
+      size_ += size;
+    } else
+      spill(data, size);
+  }
+
+  // Returns whether the output no longer fits in the stack buffer.
+  constexpr bool on_heap() const noexcept { return size_ > N; }
+
+  constexpr std::string_view view() const noexcept {
+    if (on_heap())
+      return heap_;
+    return {stack_, size_};
+  }
+
+  // Returns a string with the output using one allocation of the exact size.
+  constexpr std::string str() const {
+    std::string_view v = view();
+    return std::string(v.data(), v.size());
+  }
+
+private:
+  constexpr void spill(const char *data, std::size_t size) {
+    if (!on_heap()) {
+      heap_.reserve(2 * N + size);
+      heap_.append(stack_, size_);
+    }
+    heap_.append(data, size);
+    size_ = heap_.size();
+  }
+
+  char stack_[N];
+  std::size_t size_{0};
+  std::string heap_;
+};
+
+} // namespace ctf
+
+#endif // CTF_SCRATCH_BUFFER_HPP
@@ -0,0 +1,226 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CTF_SINK_HPP
+#define CTF_SINK_HPP
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <utility>
+
+#include <unistd.h>
+
+namespace ctf {
+
+// A target for formatted output.
+//
+// The output is written in blocks, the literal text of the format string is
+// always written with one call. Optionally a sink has the member functions
+// - reserve(n), a hint n more elements will be written,
+// - write_literal(data), writes data with static storage duration, the sink
+//   may store a pointer to data instead of copying it, and
+// - flush(), writes buffered output to the final destination.
+template <class S, class CharT = char>
+concept sink = requires(S &s, std::span<const CharT> data) { s.write(data); };
+
+namespace detail {
+
+template <class S> constexpr void sink_reserve(S &sink, std::size_t size) {
+  if constexpr (requires { sink.reserve(size); })
+    sink.reserve(size);
+}
+
+// Writes all data to the file descriptor fd.
+//
+// Throws a std::system_error when writing fails.
+inline void write_fd(int fd, std::string_view data) {
+  while (!data.empty()) {
+    ssize_t written = ::write(fd, data.data(), data.size());
+    if (written < 0) {
+      if (errno == EINTR)
+        continue;
+      throw std::system_error(errno, std::generic_category(),
+                              "failed to write the formatted output");
+    }
+    data.remove_prefix(written);
+  }
+}
+
+} // namespace detail
+
+// An output iterator writing to a sink.
+//
+// This is used for the output of the formatters. The literal text is written
+// with the member function write_literal.
+template <class S, class CharT> class sink_iterator {
+public:
+  using difference_type = std::ptrdiff_t;
+
+  constexpr explicit sink_iterator(S &sink) noexcept
+      : sink_(std::addressof(sink)) {}
+
+  constexpr sink_iterator &operator*() noexcept { return *this; }
+  constexpr sink_iterator &operator++() noexcept { return *this; }
+  constexpr sink_iterator &operator++(int) noexcept { return *this; }
+
+  constexpr sink_iterator &operator=(CharT c) {
+    sink_->write(std::span<const CharT>{&c, 1});
+    return *this;
+  }
+
+  // Writes the literal text of the format string.
+  constexpr void write_literal(std::span<const CharT> data) {
+    if constexpr (requires { sink_->write_literal(data); })
+      sink_->write_literal(data);
+    else
+      sink_->write(data);
+  }
+
+  // Writes a block of output, formatters use this instead of writing one
+  // element at a time.
+  constexpr void write(std::span<const CharT> data) { sink_->write(data); }
+
+  // A hint size more elements will be written.
+  constexpr void reserve(std::size_t size) {
+    detail::sink_reserve(*sink_, size);
+  }
+
+private:
+  S *sink_;
+};
+
+// Appends the output to a string.
+template <class CharT> class string_sink {
+public:
+  constexpr explicit string_sink(std::basic_string<CharT> &str) noexcept
+      : str_(std::addressof(str)) {}
+
+  constexpr void write(std::span<const CharT> data) {
+    str_->append(data.data(), data.size());
+  }
+
+  // Keeps the geometric growth of the string, an exact reservation would make
+  // appending several outputs quadratic.
+  constexpr void reserve(std::size_t size) {
+    if (str_->capacity() - str_->size() < size)
+      str_->reserve(std::max(str_->size() + size, 2 * str_->capacity()));
+  }
+
+private:
+  std::basic_string<CharT> *str_;
+};
+
+// Writes the output to a buffer of fixed size.
+//
+// Output that does not fit in the buffer is discarded.
+template <class CharT> class fixed_buffer_sink {
+public:
+  constexpr explicit fixed_buffer_sink(std::span<CharT> buffer) noexcept
+      : buffer_(buffer) {}
+
+  constexpr void write(std::span<const CharT> data) {
+    std::size_t n = std::min(data.size(), buffer_.size() - size_);
+    std::copy_n(data.data(), n, buffer_.data() + size_);
+    size_ += n;
+    truncated_ |= n != data.size();
+  }
+
+  constexpr std::size_t size() const noexcept { return size_; }
+  constexpr bool truncated() const noexcept { return truncated_; }
+
+  constexpr std::basic_string_view<CharT> view() const noexcept {
+    return {buffer_.data(), size_};
+  }
+
+private:
+  std::span<CharT> buffer_;
+  std::size_t size_{0};
+  bool truncated_{false};
+};
+
+template <class CharT, std::size_t N>
+fixed_buffer_sink(CharT (&)[N]) -> fixed_buffer_sink<CharT>;
+
+// The size of the buffer of a fd_sink.
+inline constexpr std::size_t fd_sink_buffer_size = 4096;
+
+// Writes the output to a file descriptor.
+//
+// The output is buffered, the buffer is written when it is full, on flush, and
+// on destruction. Errors are reported by throwing a std::system_error, except
+// in the destructor where they are ignored.
+class fd_sink {
+public:
+  explicit fd_sink(int fd) noexcept : fd_(fd) {}
+
+  ~fd_sink() {
+    try {
+      flush();
+    } catch (...) {
+    }
+  }
+
+  fd_sink(const fd_sink &) = delete;
+  fd_sink &operator=(const fd_sink &) = delete;
+
+  void write(std::span<const char> data) {
+    if (data.size() > fd_sink_buffer_size - size_) {
+      flush();
+      if (data.size() >= fd_sink_buffer_size) {
+        detail::write_fd(fd_, {data.data(), data.size()});
+        return;
+      }
+    }
+    std::copy_n(data.data(), data.size(), &buffer_[size_]);
+    size_ += data.size();
+  }
+
+  void flush() {
+    // Reset first, a failed write should not be repeated by the destructor.
+    std::size_t size = std::exchange(size_, 0);
+    detail::write_fd(fd_, {buffer_, size});
+  }
+
+private:
+  int fd_;
+  std::size_t size_{0};
+  char buffer_[fd_sink_buffer_size];
+};
+
+// Counts the number of elements of the output.
+class counting_sink {
+public:
+  template <class CharT>
+  constexpr void write(std::span<const CharT> data) noexcept {
+    size_ += data.size();
+  }
+
+  constexpr std::size_t size() const noexcept { return size_; }
+
+private:
+  std::size_t size_{0};
+};
+
+// Discards the output.
+//
+// This is intended to measure the cost of formatting without the cost of
+// storing the output.
+class null_sink {
+public:
+  template <class CharT>
+  constexpr void write(std::span<const CharT>) noexcept {}
+};
+
+} // namespace ctf
+
+#endif // CTF_SINK_HPP
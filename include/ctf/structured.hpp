@@ -0,0 +1,188 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CTF_STRUCTURED_HPP
+#define CTF_STRUCTURED_HPP
+
+#include "escape.hpp"
+#include "format.hpp"
+#include "sink.hpp"
+#include "utility.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <iterator>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace ctf {
+
+// The encoding of a structured record.
+enum class structured_format {
+  // A JSON object, {"name":value,...}.
+  json,
+  // The logfmt key/value pairs, name=value ...
+  logfmt
+};
+
+namespace detail {
+
+template <class R> void write_record(R &record, std::string_view data) {
+  record.write(std::span<const char>{data.data(), data.size()});
+}
+
+// Writes s as a JSON string.
+template <class R> void write_json_string(R &record, std::string_view s) {
+  detail::write_record(record, "\"");
+  detail::escape<escape_kind::json>(
+      s, [&](std::string_view data) { detail::write_record(record, data); });
+  detail::write_record(record, "\"");
+}
+
+// Writes s as a logfmt value.
+//
+// The value is quoted when it is empty or contains a space, '=', '"', or a
+// control character.
+template <class R> void write_logfmt_string(R &record, std::string_view s) {
+  bool quote = s.empty() || std::ranges::any_of(s, [](unsigned char c) {
+                 return c <= ' ' || c == '=' || c == '"' || c == 0x7f;
+               });
+  if (quote)
+    detail::write_json_string(record, s);
+  else
+    detail::write_record(record, s);
+}
+
+// Writes the value of an argument in the record.
+//
+// Numbers and booleans are written without quotes, other values as a
+// string. For strings and characters that is the value itself, for other
+// types the output of their formatter.
+template <structured_format kind, class R, class T>
+void write_structured_value(R &record, const T &value) {
+  auto write_string = [&](std::string_view s) {
+    if constexpr (kind == structured_format::json)
+      detail::write_json_string(record, s);
+    else
+      detail::write_logfmt_string(record, s);
+  };
+
+  if constexpr (std::same_as<T, bool>)
+    detail::write_record(record, value ? "true" : "false");
+  else if constexpr (std::same_as<T, char>)
+    write_string({&value, 1});
+  else if constexpr (std::integral<T>) {
+    char buffer[64];
+    detail::write_record(
+        record, {buffer, std::to_chars(buffer, std::end(buffer), value).ptr});
+  } else if constexpr (std::floating_point<T>) {
+    // JSON has no representation for infinity and NaN.
+    if (kind == structured_format::json && !std::isfinite(value))
+      detail::write_record(record, "null");
+    else {
+      char buffer[64];
+      detail::write_record(
+          record, {buffer, std::to_chars(buffer, std::end(buffer), value).ptr});
+    }
+  } else if constexpr (std::convertible_to<const T &, std::string_view>)
+    write_string(value);
+  else
+    write_string(ctf::format<"{}">(value));
+}
+
+// A name of a field can be written in a record without escaping.
+consteval bool valid_field_name(std::string_view name) {
+  return !name.empty() && std::ranges::all_of(name, [](char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+           (c >= '0' && c <= '9') || c == '_' || c == '.' || c == '-';
+  });
+}
+
+template <structured_format kind, fixed_string... names, class R,
+          class... Args>
+void write_structured_record(R &record, const Args &...args) {
+  static_assert((detail::valid_field_name(
+                     std::string_view{names.private_str_, names.size()}) &&
+                 ...),
+                "the name of a field may only contain letters, digits, '_', "
+                "'.', and '-'");
+
+  if constexpr (kind == structured_format::json)
+    detail::write_record(record, "{");
+
+  bool first = true;
+  (
+      [&] {
+        if (!first)
+          detail::write_record(record,
+                               kind == structured_format::json ? "," : " ");
+        first = false;
+
+        std::string_view name{names.private_str_, names.size()};
+        if constexpr (kind == structured_format::json) {
+          detail::write_record(record, "\"");
+          detail::write_record(record, name);
+          detail::write_record(record, "\":");
+        } else {
+          detail::write_record(record, name);
+          detail::write_record(record, "=");
+        }
+        detail::write_structured_value<kind>(
+            record, ctf::as_format_arg<char>(args));
+      }(),
+      ...);
+
+  if constexpr (kind == structured_format::json)
+    detail::write_record(record, "}");
+}
+
+} // namespace detail
+
+// Writes the output of the format string to text and the arguments as a
+// structured record to record.
+//
+// The names are the names of the fields in the record, one for every
+// argument, in the order of the arguments. Since the arg-ids of the format
+// string are numbers the names are given as a list. An argument used more
+// than once in the format string is one field of the record.
+//
+// The text is formatted like ctf::format_to. In the record numbers and
+// booleans are written as numbers and booleans, other values as strings.
+template <fixed_string fmt, fixed_string... names, class S, class R,
+          class... Args>
+  requires std::same_as<typename decltype(fmt)::char_type, char> &&
+           sink<S, char> && sink<R, char>
+void format_structured(S &text, R &record, Args &&...args) {
+  static_assert(sizeof...(names) == sizeof...(Args),
+                "every argument needs a name");
+  ctf::format_to<fmt>(text, args...);
+  detail::write_structured_record<structured_format::json, names...>(
+      record, args...);
+}
+
+// Writes the output of the format string to text and the arguments as logfmt
+// key/value pairs to record.
+template <fixed_string fmt, fixed_string... names, class S, class R,
+          class... Args>
+  requires std::same_as<typename decltype(fmt)::char_type, char> &&
+           sink<S, char> && sink<R, char>
+void format_logfmt(S &text, R &record, Args &&...args) {
+  static_assert(sizeof...(names) == sizeof...(Args),
+                "every argument needs a name");
+  ctf::format_to<fmt>(text, args...);
+  detail::write_structured_record<structured_format::logfmt, names...>(
+      record, args...);
+}
+
+} // namespace ctf
+
+#endif // CTF_STRUCTURED_HPP
@@ -0,0 +1,479 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CTF_TEXT_TEMPLATE_HPP
+#define CTF_TEXT_TEMPLATE_HPP
+
+#include "format.hpp"
+#include "format_error.hpp"
+#include "formatter.hpp"
+#include "parse.hpp"
+#include "sink.hpp"
+#include "utility.hpp"
+
+#include <algorithm>
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <format>
+#include <iterator>
+#include <ranges>
+#include <span>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Text templates with sections and conditionals.
+//
+// A template contains literal text and tags:
+// - {name} or {name:format-spec}, a field formatting the argument name,
+// - {#name}...{/name}, a section repeating its body for every element of the
+//   range name,
+// - {?name}...{/name}, a conditional writing its body when name is true, or
+//   for a range when it is not empty, and
+// - {^name}...{/name}, a conditional writing its body otherwise.
+// In the body of a section {.} refers to the current element and {.N} to
+// element N of a tuple-like current element. These can be used in all tags.
+// Like in a format string {{ and }} are escaped braces.
+//
+// The template is parsed at compile-time in a flat list of nodes, where a
+// section refers to the end of its body. The parser is a loop and the
+// rendering only recurses for nested sections, so large templates do not
+// reach the template instantiation depth.
+namespace ctf {
+
+// An argument of a template, referring to value.
+template <fixed_string Name, class T> struct named_arg {
+  static constexpr auto name = Name;
+  const T &value;
+};
+
+template <fixed_string name, class T>
+constexpr named_arg<name, T> arg(const T &value) {
+  return {value};
+}
+
+namespace detail {
+
+template <class T> inline constexpr bool is_named_arg = false;
+
+template <fixed_string name, class T>
+inline constexpr bool is_named_arg<named_arg<name, T>> = true;
+
+enum class template_kind { text, field, section, conditional, inverted };
+
+inline constexpr std::size_t template_npos = std::size_t(-1);
+
+struct template_node {
+  template_kind kind = template_kind::text;
+  // The literal text, or the tag, in the template.
+  std::size_t offset = 0;
+  std::size_t size = 0;
+  // The index of the argument, template_npos for the current element.
+  std::size_t arg = template_npos;
+  // The tuple element of the value, template_npos for the value itself.
+  std::size_t element = template_npos;
+  // The offset of the format-spec of a field.
+  std::size_t spec = 0;
+  // The index of the node after the body of a section or conditional.
+  std::size_t end = 0;
+};
+
+struct template_parse_result {
+  std::vector<template_node> nodes;
+
+  // The error message and the offsets of the tag containing the error.
+  std::string error;
+  std::size_t begin = 0;
+  std::size_t caret = 0;
+};
+
+consteval bool is_name_char(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+         (c >= '0' && c <= '9') || c == '_';
+}
+
+// Parses the template fmt for the arguments with the names names.
+template <fixed_string fmt, fixed_string... names>
+consteval template_parse_result parse_template() {
+  const std::array<std::string_view, sizeof...(names)> arguments{
+      std::string_view{names.private_str_, names.size()}...};
+  const std::string_view input{fmt.private_str_, fmt.size()};
+
+  template_parse_result result;
+  auto fail = [&](std::string message, std::size_t begin, std::size_t caret) {
+    result.error = std::move(message);
+    result.begin = begin;
+    result.caret = caret;
+    return result;
+  };
+
+  for (std::size_t i = 0; i != arguments.size(); ++i)
+    if (std::ranges::count(arguments, arguments[i]) != 1)
+      return fail("the name " + std::string(arguments[i]) +
+                      " is used by more than one argument",
+                  0, 0);
+
+  // The sections and conditionals without a closing tag.
+  std::vector<std::size_t> open;
+  std::size_t text = 0;
+  auto add_text = [&](std::size_t last) {
+    if (text != last)
+      result.nodes.push_back({template_kind::text, text, last - text});
+  };
+
+  for (std::size_t i = 0; i < input.size();) {
+    if (input[i] == '}') {
+      if (fmt[i + 1] != '}')
+        return fail("expected '}' in escape sequence", i, i);
+      add_text(i + 1);
+      text = i += 2;
+      continue;
+    }
+    if (input[i] != '{') {
+      ++i;
+      continue;
+    }
+    if (fmt[i + 1] == '{') {
+      add_text(i + 1);
+      text = i += 2;
+      continue;
+    }
+
+    add_text(i);
+    template_node node{template_kind::field, i};
+    std::size_t begin = i++;
+    bool close = false;
+    switch (input[i]) {
+    case '#':
+      node.kind = template_kind::section;
+      ++i;
+      break;
+    case '?':
+      node.kind = template_kind::conditional;
+      ++i;
+      break;
+    case '^':
+      node.kind = template_kind::inverted;
+      ++i;
+      break;
+    case '/':
+      close = true;
+      ++i;
+      break;
+    }
+
+    std::size_t name = i;
+    if (fmt[i] == '.') {
+      ++i;
+      if (fmt[i] >= '0' && fmt[i] <= '9') {
+        node.element = 0;
+        for (; fmt[i] >= '0' && fmt[i] <= '9'; ++i)
+          node.element = node.element * 10 + (fmt[i] - '0');
+      }
+    } else {
+      for (; is_name_char(fmt[i]); ++i)
+        ;
+      if (i == name)
+        return fail("expected a name or '.'", begin, i);
+      auto it = std::ranges::find(arguments, input.substr(name, i - name));
+      if (it == arguments.end())
+        return fail("there is no argument with this name", begin, name);
+      node.arg = it - arguments.begin();
+    }
+
+    if (node.kind == template_kind::field && !close && fmt[i] == ':') {
+      // The format-spec is validated by the formatter.
+      node.spec = i + 1;
+      for (std::size_t level = 0; i < input.size(); ++i)
+        if (input[i] == '{')
+          ++level;
+        else if (input[i] == '}' && level-- == 0)
+          break;
+      if (i == input.size())
+        return fail("unable to find the end of the format-spec", begin, i);
+    } else {
+      node.spec = i;
+      if (fmt[i] != '}')
+        return fail(i == input.size()
+                        ? "unexpected end of the template"
+                        : "unexpected character in the tag, expected '}'",
+                    begin, i);
+    }
+    node.size = ++i - begin;
+    text = i;
+
+    if (close) {
+      if (open.empty())
+        return fail("the closing tag has no matching opening tag", begin,
+                    name);
+      const template_node &opening = result.nodes[open.back()];
+      if (input.substr(name, i - 1 - name) !=
+          input.substr(opening.offset + 2, opening.size - 3))
+        return fail("the closing tag does not match the opening tag at " +
+                        ctf::to_string(opening.offset),
+                    begin, name);
+      result.nodes[open.back()].end = result.nodes.size();
+      open.pop_back();
+    } else {
+      if (node.kind != template_kind::field)
+        open.push_back(result.nodes.size());
+      result.nodes.push_back(node);
+    }
+  }
+  add_text(input.size());
+
+  if (!open.empty()) {
+    const template_node &opening = result.nodes[open.back()];
+    return fail("the tag has no closing tag", opening.offset,
+                opening.offset + opening.size - 1);
+  }
+  return result;
+}
+
+// The result of parse_template without allocations.
+//
+// This allows storing the result in a constexpr variable, so the template is
+// parsed once. Every node contains at least one character of the template.
+template <std::size_t N, std::size_t M> struct template_plan_result {
+  std::array<template_node, N> nodes{};
+  std::size_t size = 0;
+
+  std::array<char, M> error{};
+  std::size_t error_size = 0;
+  std::size_t begin = 0;
+  std::size_t caret = 0;
+};
+
+// Returns the nodes of the template or a format_error.
+template <fixed_string fmt, fixed_string... names>
+consteval auto template_plan() {
+  // The longest error message contains a name or an offset.
+  constexpr auto plan = []() consteval {
+    template_parse_result parsed = detail::parse_template<fmt, names...>();
+    template_plan_result<fmt.size(),
+                         96 + (std::size_t(0) + ... + names.size())>
+        result;
+    result.size = parsed.nodes.size();
+    std::ranges::copy(parsed.nodes, result.nodes.begin());
+    result.error_size = parsed.error.size();
+    std::ranges::copy(parsed.error, result.error.begin());
+    result.begin = parsed.begin;
+    result.caret = parsed.caret;
+    return result;
+  }();
+
+  if constexpr (plan.error_size != 0)
+    return ctf::create_format_error(
+        std::string{plan.error.data(), plan.error_size}, fmt, plan.begin,
+        plan.caret, plan.caret);
+  else {
+    std::array<template_node, plan.size> result;
+    std::ranges::copy_n(plan.nodes.begin(), plan.size, result.begin());
+    return result;
+  }
+}
+
+// The current element outside a section.
+struct no_element {};
+
+template <fixed_string fmt, class... Args> class template_renderer {
+public:
+  using arguments = std::tuple<const Args &...>;
+
+  static constexpr auto nodes = detail::template_plan<fmt, Args::name...>();
+
+  // The size of the literal text outside the sections.
+  static consteval std::size_t literal_size() {
+    std::size_t result = 0;
+    for (std::size_t i = 0; i != nodes.size(); i = next(i))
+      if (nodes[i].kind == template_kind::text)
+        result += nodes[i].size;
+    return result;
+  }
+
+  // Writes the output of the nodes from first up to last.
+  //
+  // The bodies of the sections and conditionals are written by their node.
+  template <std::size_t first, std::size_t last, class S, class E>
+  static void render(S &sink, const arguments &args, const E &element) {
+    static constexpr auto indices = children<first, last>();
+    std::__for_each_index_sequence(
+        std::make_index_sequence<indices.size()>(), [&]<std::size_t I> {
+          render_node<indices[I]>(sink, args, element);
+        });
+  }
+
+private:
+  static consteval std::size_t next(std::size_t i) {
+    return nodes[i].kind == template_kind::text ||
+                   nodes[i].kind == template_kind::field
+               ? i + 1
+               : nodes[i].end;
+  }
+
+  template <std::size_t first, std::size_t last>
+  static consteval auto children() {
+    constexpr std::size_t size = [] {
+      std::size_t result = 0;
+      for (std::size_t i = first; i != last; i = next(i))
+        ++result;
+      return result;
+    }();
+    std::array<std::size_t, size> result;
+    for (std::size_t i = first, j = 0; i != last; i = next(i))
+      result[j++] = i;
+    return result;
+  }
+
+  static consteval format_error error(std::string message,
+                                      template_node node) {
+    return ctf::create_format_error(std::move(message), fmt, node.offset,
+                                    node.offset, node.offset + node.size - 1);
+  }
+
+  template <template_node node, class E>
+  static const auto &base(const arguments &args, const E &element) {
+    if constexpr (node.arg == template_npos)
+      return element;
+    else
+      return std::get<node.arg>(args).value;
+  }
+
+  // The sink_iterator writes the output of a formatter one element at a time,
+  // a string is appended by push_back.
+  template <class S> static auto output(S &out) {
+    if constexpr (std::same_as<S, std::string>)
+      return std::back_inserter(out);
+    else
+      return sink_iterator<S, char>{out};
+  }
+
+  template <std::size_t I, class S, class E>
+  static void render_node(S &sink, const arguments &args, const E &element) {
+    constexpr template_node node = nodes[I];
+    if constexpr (node.kind == template_kind::text &&
+                  std::same_as<S, std::string>)
+      sink.append(&fmt[node.offset], node.size);
+    else if constexpr (node.kind == template_kind::text)
+      sink_iterator<S, char>{sink}.write_literal(
+          std::span<const char>{&fmt[node.offset], node.size});
+    else if constexpr (node.arg == template_npos &&
+                       std::same_as<E, no_element>)
+      static_assert(!"template error",
+                    error("the current element is only available in the body "
+                          "of a section",
+                          node));
+    else {
+      const auto &b = base<node>(args, element);
+      using B = std::remove_cvref_t<decltype(b)>;
+      if constexpr (node.element == template_npos)
+        render_value<I>(sink, args, element, b);
+      else if constexpr (!requires { std::tuple_size<B>::value; })
+        static_assert(!"template error",
+                      error("the value is not a tuple-like type", node));
+      else if constexpr (node.element >= std::tuple_size_v<B>)
+        static_assert(!"template error",
+                      error("the tuple-like value has no element with this "
+                            "index",
+                            node));
+      else
+        render_value<I>(sink, args, element, std::get<node.element>(b));
+    }
+  }
+
+  template <std::size_t I, class S, class E, class T>
+  static void render_value(S &sink, const arguments &args, const E &element,
+                           const T &value) {
+    constexpr template_node node = nodes[I];
+    if constexpr (node.kind == template_kind::field) {
+      using F = std::remove_cvref_t<format_arg_t<char, T>>;
+      if constexpr (!std::formattable<F, char>)
+        static_assert(!"template error",
+                      error("the value is not formattable", node));
+      else {
+        // The format-spec can't refer to other arguments.
+        static constexpr auto result = ctf::formatter<
+            F, fmt, node.spec,
+            arg_id_status<index_mode::unknown, 0, 0>{}>::create();
+        if constexpr (ctf::is_format_error(result))
+          static_assert(!"parse error", result);
+        else {
+          std::tuple<> format_args;
+          ctf::format_replacement_field<char>(
+              result.formatter, ctf::as_format_arg<char>(value), format_args,
+              output(sink));
+        }
+      }
+    } else if constexpr (node.kind == template_kind::section) {
+      if constexpr (!std::ranges::input_range<const T>)
+        static_assert(
+            !"template error",
+            error("the value of a section needs to be a range", node));
+      else
+        for (const auto &e : value)
+          render<I + 1, node.end>(sink, args, e);
+    } else if constexpr (std::ranges::forward_range<const T>) {
+      if ((std::ranges::begin(value) != std::ranges::end(value)) ==
+          (node.kind == template_kind::conditional))
+        render<I + 1, node.end>(sink, args, element);
+    } else {
+      if constexpr (!std::constructible_from<bool, const T &>)
+        static_assert(!"template error",
+                      error("the value of a conditional needs to be a range "
+                            "or convertible to bool",
+                            node));
+      else if (static_cast<bool>(value) ==
+               (node.kind == template_kind::conditional))
+        render<I + 1, node.end>(sink, args, element);
+    }
+  }
+};
+
+// Writes the output to the sink or appends it to the std::string out.
+template <fixed_string fmt, class S, class... Args>
+void render_to(S &out, const Args &...args) {
+  using R = template_renderer<fmt, Args...>;
+  if constexpr (ctf::is_format_error(R::nodes))
+    static_assert(!"parse error", R::nodes);
+  else {
+    detail::sink_reserve(out, R::literal_size());
+    R::template render<0, R::nodes.size()>(out, typename R::arguments{args...},
+                                           no_element{});
+  }
+}
+
+} // namespace detail
+
+// Writes the output of the template to the sink.
+//
+// The arguments are created with ctf::arg<"name">(value). The template is
+// parsed at compile-time, the format-specs of the fields are parsed by the
+// same formatters as ctf::format.
+template <fixed_string fmt, class S, class... Args>
+  requires std::same_as<typename decltype(fmt)::char_type, char> &&
+           sink<S, char> && (detail::is_named_arg<Args> && ...)
+void render_to(S &sink, const Args &...args) {
+  detail::render_to<fmt>(sink, args...);
+}
+
+// Returns the output of the template.
+template <fixed_string fmt, class... Args>
+  requires std::same_as<typename decltype(fmt)::char_type, char> &&
+           (detail::is_named_arg<Args> && ...)
+std::string render(const Args &...args) {
+  std::string result;
+  detail::render_to<fmt>(result, args...);
+  return result;
+}
+
+} // namespace ctf
+
+#endif // CTF_TEXT_TEMPLATE_HPP
@@ -0,0 +1,99 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CTF_TRANSCODING_ITERATOR_HPP
+#define CTF_TRANSCODING_ITERATOR_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+
+namespace ctf {
+
+// An output iterator converting UTF-8 to the encoding of CharT.
+//
+// This is used to write the output of the char formatters directly in a
+// char8_t, char16_t, or char32_t output, without an intermediate string. The
+// decoder state is stored in the iterator. The formatters return the iterator
+// after the last written code unit, that iterator is used for the next write.
+//
+// Ill-formed UTF-8 sequences are replaced by U+FFFD REPLACEMENT CHARACTER.
+template <class OutIt, class CharT> class transcoding_iterator {
+public:
+  using difference_type = std::ptrdiff_t;
+
+  constexpr explicit transcoding_iterator(OutIt out) : out_(std::move(out)) {}
+
+  constexpr transcoding_iterator &operator*() noexcept { return *this; }
+  constexpr transcoding_iterator &operator++() noexcept { return *this; }
+  constexpr transcoding_iterator &operator++(int) noexcept { return *this; }
+
+  constexpr transcoding_iterator &operator=(char c) {
+    if constexpr (sizeof(CharT) == 1)
+      *out_++ = static_cast<CharT>(c);
+    else
+      decode(static_cast<unsigned char>(c));
+    return *this;
+  }
+
+  // Returns the underlying iterator.
+  //
+  // The output of a formatter never ends in the middle of a code point, so
+  // there is no pending state to write.
+  constexpr OutIt base() && { return std::move(out_); }
+
+private:
+  constexpr void decode(unsigned char c) {
+    if (pending_ != 0) {
+      if ((c & 0b1100'0000) == 0b1000'0000) {
+        code_point_ = (code_point_ << 6) | (c & 0b0011'1111);
+        if (--pending_ == 0)
+          encode(code_point_);
+        return;
+      }
+      // The sequence is truncated, c starts a new sequence.
+      pending_ = 0;
+      encode(0xFFFD);
+    }
+
+    if (c < 0b1000'0000)
+      encode(c);
+    else if ((c & 0b1110'0000) == 0b1100'0000)
+      start(c & 0b0001'1111, 1);
+    else if ((c & 0b1111'0000) == 0b1110'0000)
+      start(c & 0b0000'1111, 2);
+    else if ((c & 0b1111'1000) == 0b1111'0000)
+      start(c & 0b0000'0111, 3);
+    else
+      encode(0xFFFD);
+  }
+
+  constexpr void start(std::uint32_t bits, int pending) {
+    code_point_ = bits;
+    pending_ = pending;
+  }
+
+  constexpr void encode(std::uint32_t code_point) {
+    if constexpr (sizeof(CharT) == 2) {
+      if (code_point >= 0x10000) {
+        code_point -= 0x10000;
+        *out_++ = static_cast<CharT>(0xD800 + (code_point >> 10));
+        *out_++ = static_cast<CharT>(0xDC00 + (code_point & 0x3FF));
+        return;
+      }
+    }
+    *out_++ = static_cast<CharT>(code_point);
+  }
+
+  OutIt out_;
+  std::uint32_t code_point_{0};
+  int pending_{0};
+};
+
+} // namespace ctf
+
+#endif // CTF_TRANSCODING_ITERATOR_HPP
@@ -0,0 +1,327 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CTF_UNITS_HPP
+#define CTF_UNITS_HPP
+
+// This uses libc++'s implementation details to parse the format-spec and write
+// the padding.
+#include <version>
+#ifndef _LIBCPP_VERSION
+#error This header requires libc++'s format implementation
+#endif
+
+#include "fixed.hpp"
+#include "format_error.hpp"
+#include "formatter.hpp"
+#include "formatter_string.hpp"
+#include "max_size.hpp"
+#include "utility.hpp"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <chrono>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <format>
+#include <iterator>
+#include <limits>
+#include <ratio>
+#include <string_view>
+
+namespace ctf {
+
+// The display types writing a value with a unit.
+//
+// The unit is the largest unit not larger than the value, the value is
+// written with a fraction of precision digits, 1 by default. The base unit is
+// written without a fraction.
+enum class unit_type {
+  none,
+  // {:iB}, an unsigned integer as bytes in the binary units B, KiB, MiB, ...
+  binary_bytes,
+  // {:sB}, an unsigned integer as bytes in the SI units B, kB, MB, ...
+  si_bytes,
+  // {:hd}, a std::chrono::duration in the units ns, us, ms, s, min, h, and d.
+  duration
+};
+
+namespace detail {
+
+struct unit_table {
+  std::array<std::string_view, 7> names;
+  // The size of every unit in the base unit.
+  std::array<std::uint64_t, 7> sizes;
+};
+
+template <unit_type kind> inline constexpr unit_table units = [] {
+  if constexpr (kind == unit_type::binary_bytes)
+    return unit_table{{"B", "KiB", "MiB", "GiB", "TiB", "PiB", "EiB"},
+                      {1, 1ull << 10, 1ull << 20, 1ull << 30, 1ull << 40,
+                       1ull << 50, 1ull << 60}};
+  else if constexpr (kind == unit_type::si_bytes)
+    return unit_table{{"B", "kB", "MB", "GB", "TB", "PB", "EB"},
+                      {1, 1'000, 1'000'000, 1'000'000'000,
+                       1'000'000'000'000, 1'000'000'000'000'000,
+                       1'000'000'000'000'000'000}};
+  else
+    return unit_table{{"ns", "us", "ms", "s", "min", "h", "d"},
+                      {1, 1'000, 1'000'000, 1'000'000'000, 60'000'000'000,
+                       3'600'000'000'000, 86'400'000'000'000}};
+}();
+
+// The largest value of the precision.
+inline constexpr int unit_max_precision = 9;
+
+// The largest magnitude of a duration in nanoseconds.
+//
+// Longer durations are written as this value, 9223372036 days, the largest
+// number of days whose scaled value fits in a std::int64_t.
+inline constexpr unsigned __int128 unit_max_duration =
+    static_cast<unsigned __int128>(std::numeric_limits<std::int64_t>::max() /
+                                   powers_of_10[unit_max_precision]) *
+    86'400'000'000'000;
+
+// The size of the buffer for the output without padding.
+inline constexpr std::size_t unit_buffer_size = 32;
+
+// The index of the largest unit not larger than value.
+//
+// For the binary units this is log2(value) / 10, otherwise the number of
+// units not larger than value. Neither needs a branch.
+template <unit_type kind, class UInt>
+constexpr std::size_t select_unit(UInt value) {
+  if constexpr (kind == unit_type::binary_bytes)
+    return (std::bit_width(value | 1) - 1) / 10;
+  else {
+    std::size_t result = 0;
+    for (std::size_t i = 1; i != units<kind>.sizes.size(); ++i)
+      result += value >= units<kind>.sizes[i];
+    return result;
+  }
+}
+
+// Returns value in the unit index, multiplied by 10^precision and rounded.
+template <unit_type kind, std::size_t precision, class UInt>
+constexpr std::uint64_t scale_unit(UInt value, std::size_t index) {
+  unsigned __int128 scaled =
+      static_cast<unsigned __int128>(value) * powers_of_10[precision];
+  std::uint64_t size = units<kind>.sizes[index];
+  if constexpr (kind == unit_type::binary_bytes)
+    return (scaled + size / 2) >> (10 * index);
+  else
+    return (scaled + size / 2) / size;
+}
+
+// Writes the magnitude with its unit backwards from last.
+template <unit_type kind, std::size_t precision, class UInt>
+constexpr char *write_unit(char *last, bool negative, UInt magnitude) {
+  constexpr const unit_table &table = units<kind>;
+  std::size_t index = detail::select_unit<kind>(magnitude);
+  // The base unit is not scaled, the magnitude is less than the next unit.
+  std::uint64_t scaled = static_cast<std::uint64_t>(magnitude);
+  if (index != 0) {
+    scaled = detail::scale_unit<kind, precision>(magnitude, index);
+    // Rounding can reach the next unit; 1023.96 KiB is written as 1.0 MiB.
+    if (index + 1 != table.sizes.size() &&
+        scaled >= table.sizes[index + 1] / table.sizes[index] *
+                      powers_of_10[precision])
+      scaled = detail::scale_unit<kind, precision>(magnitude, ++index);
+  }
+
+  std::string_view name = table.names[index];
+  last -= name.size();
+  std::ranges::copy(name, last);
+  *--last = ' ';
+
+  std::int64_t value = negative ? -std::int64_t(scaled) : std::int64_t(scaled);
+  if (index == 0)
+    return detail::write_fixed<0>(last, value,
+                                  std::__format_spec::__sign::__default, '\0');
+  return detail::write_fixed<precision>(
+      last, value, std::__format_spec::__sign::__default, '\0');
+}
+
+// The unit display type at the end of the format-spec starting at begin.
+//
+// This selects the formatter for the argument before the format-spec is
+// parsed, the other format-specs of these types are parsed by their
+// std::formatter.
+template <fixed_string fmt, std::size_t begin>
+consteval unit_type unit_type_of() {
+  std::size_t end = begin;
+  for (std::size_t level = 0; end != fmt.size(); ++end)
+    if (fmt[end] == '{')
+      ++level;
+    else if (fmt[end] == '}') {
+      if (level == 0)
+        break;
+      --level;
+    }
+
+  if (end - begin < 2)
+    return unit_type::none;
+  std::string_view spec{&fmt[begin], &fmt[end]};
+  if (spec.ends_with("iB"))
+    return unit_type::binary_bytes;
+  if (spec.ends_with("sB"))
+    return unit_type::si_bytes;
+  // A chrono-spec can end with the literal text hd.
+  if (spec.ends_with("hd") && !spec.contains('%'))
+    return unit_type::duration;
+  return unit_type::none;
+}
+
+// The character types are excluded, char and wchar_t are unsigned on some
+// platforms.
+template <class T>
+concept unit_integer =
+    std::unsigned_integral<T> && !std::same_as<T, bool> &&
+    !std::same_as<T, char> && !std::same_as<T, wchar_t> &&
+    !std::same_as<T, char8_t> && !std::same_as<T, char16_t> &&
+    !std::same_as<T, char32_t> && sizeof(T) <= sizeof(std::uint64_t);
+
+// Returns the magnitude of value in nanoseconds.
+//
+// Like std::chrono::duration_cast the value is truncated, but this does not
+// overflow; the result is at most unit_max_duration.
+template <class Rep, class Period>
+constexpr unsigned __int128
+duration_magnitude(std::chrono::duration<Rep, Period> value) {
+  using ratio = std::ratio_divide<Period, std::nano>;
+  if constexpr (std::floating_point<Rep>) {
+    long double ns = static_cast<long double>(value.count()) * ratio::num /
+                     ratio::den;
+    if (ns < 0)
+      ns = -ns;
+    // NaN is written as the largest duration too.
+    if (!(ns < static_cast<long double>(unit_max_duration)))
+      return unit_max_duration;
+    return static_cast<unsigned __int128>(ns);
+  } else {
+    Rep count = value.count();
+    unsigned __int128 magnitude = static_cast<unsigned __int128>(count);
+    if (count < Rep(0))
+      magnitude = -magnitude;
+
+    unsigned __int128 quotient = magnitude / ratio::den;
+    if (quotient > unit_max_duration / ratio::num)
+      return unit_max_duration;
+    return std::min(quotient * ratio::num +
+                        magnitude % ratio::den * ratio::num / ratio::den,
+                    unit_max_duration);
+  }
+}
+
+// The options of the std-format-spec used for the unit display types.
+//
+// unit-spec ::= [[fill]align][width]['.' precision] unit-type
+inline constexpr std::__format_spec::__fields fields_unit = [] {
+  std::__format_spec::__fields result = std::__format_spec::__fields_string;
+  result.__type_ = false;
+  result.__consume_all_ = false;
+  return result;
+}();
+
+} // namespace detail
+
+// The formatter for a unit display type.
+//
+// The precision is a template argument, so the digits are written by the
+// fixed-point kernels.
+template <unit_type kind, std::size_t precision> struct unit_formatter {
+  std::__format_spec::__parser<char> parser;
+
+  template <class T, class FormatContext>
+  typename FormatContext::iterator format(const T &value,
+                                          FormatContext &ctx) const {
+    char buffer[detail::unit_buffer_size];
+    char *last = std::end(buffer);
+    char *first;
+    if constexpr (kind == unit_type::duration)
+      first = detail::write_unit<kind, precision>(
+          last, value < value.zero(), detail::duration_magnitude(value));
+    else
+      first = detail::write_unit<kind, precision>(last, false, value);
+
+    return detail::write_number(first, last, parser, ctx);
+  }
+
+  // A sign, 10 digits for the number of days, the decimal point, the fraction,
+  // a space, and the unit.
+  consteval std::size_t max_size() const {
+    return detail::padded_max_size(parser, 16 + precision);
+  }
+};
+
+namespace detail {
+
+template <unit_type kind, fixed_string fmt, std::size_t begin,
+          arg_id_status arg_id, class... Args>
+consteval auto create_unit_formatter() {
+  using initial = detail::parse_status<begin, arg_id,
+                                       std::__format_spec::__parser<char>{}>;
+  auto status =
+      detail::parse<fmt, begin, detail::fields_unit, initial{}, Args...>();
+
+  if constexpr (ctf::is_format_error(status))
+    return status;
+  else if constexpr (status.parser.__precision_as_arg_)
+    return create_format_error(
+        "the precision of a unit display type can't be an argument", fmt,
+        begin, status.offset - 1, status.offset - 1);
+  else if constexpr (status.parser.__precision_ > unit_max_precision)
+    return create_format_error(
+        "the precision of a unit display type is at most 9", fmt, begin,
+        status.offset - 1, status.offset - 1);
+  else if constexpr (fmt[status.offset + 2] != '}')
+    return create_format_error(
+        "unexpected character in the format specification", fmt, begin,
+        status.offset, status.offset);
+  else {
+    constexpr std::size_t precision =
+        status.parser.__precision_ == -1 ? 1 : status.parser.__precision_;
+    using F = unit_formatter<kind, precision>;
+    return formatter_result<status.offset + 2, status.arg_id, F>{
+        F{status.parser}};
+  }
+}
+
+} // namespace detail
+
+// Selects the unit formatter for the {:iB} and {:sB} display types.
+template <class T, fixed_string fmt, std::size_t begin, arg_id_status arg_id,
+          class... Args>
+  requires detail::unit_integer<T> &&
+           std::same_as<char, typename decltype(fmt)::char_type> &&
+           (detail::unit_type_of<fmt, begin>() == unit_type::binary_bytes ||
+            detail::unit_type_of<fmt, begin>() == unit_type::si_bytes)
+struct formatter<T, fmt, begin, arg_id, Args...> {
+  static consteval auto create() {
+    return detail::create_unit_formatter<detail::unit_type_of<fmt, begin>(),
+                                         fmt, begin, arg_id, Args...>();
+  }
+};
+
+// Selects the unit formatter for the {:hd} display type.
+template <class Rep, class Period, fixed_string fmt, std::size_t begin,
+          arg_id_status arg_id, class... Args>
+  requires std::same_as<char, typename decltype(fmt)::char_type> &&
+           (detail::unit_type_of<fmt, begin>() == unit_type::duration)
+struct formatter<std::chrono::duration<Rep, Period>, fmt, begin, arg_id,
+                 Args...> {
+  static consteval auto create() {
+    return detail::create_unit_formatter<unit_type::duration, fmt, begin,
+                                         arg_id, Args...>();
+  }
+};
+
+} // namespace ctf
+
+#endif // CTF_UNITS_HPP
@@ -11,7 +11,9 @@
 #include <algorithm>
 #include <array>
 #include <charconv>
+#include <concepts>
 #include <cstddef>
+#include <cstdint>
 #include <string>
 
 namespace ctf {
@@ -31,7 +33,7 @@ public:
   using char_type = CharT;
 
   consteval fixed_string(const CharT (&r)[Size]) {
-    __builtin_memcpy(private_str_, r, Size);
+    __builtin_memcpy(private_str_, r, Size * sizeof(CharT));
   }
 
   // The size of the array shouldn't include the NUL character.
@@ -41,7 +43,23 @@ public:
     return private_str_[i];
   }
 
-  consteval operator std::string() const { return std::string(private_str_); }
+  // Converts the string for diagnostics.
+  //
+  // The code units of other character types are written as ASCII or as a
+  // '?'. Every code unit remains one character so the offsets used in the
+  // diagnostics are still valid.
+  consteval operator std::string() const {
+    if constexpr (sizeof(CharT) == 1)
+      return std::string(private_str_, private_str_ + size());
+    else {
+      std::string result;
+      for (std::size_t i = 0; i != size(); ++i) {
+        auto c = static_cast<std::uint32_t>(private_str_[i]);
+        result.push_back(c < 0x80 ? static_cast<char>(c) : '?');
+      }
+      return result;
+    }
+  }
 
   // When the class has a private member it's no longer a structural type and
   // can't be used as an template argument.
@@ -54,6 +72,63 @@ fixed_string(const char (&)[Size]) -> fixed_string<char, Size>;
 template <std::size_t Size>
 fixed_string(const wchar_t (&)[Size]) -> fixed_string<wchar_t, Size>;
 
+template <std::size_t Size>
+fixed_string(const char8_t (&)[Size]) -> fixed_string<char8_t, Size>;
+
+template <std::size_t Size>
+fixed_string(const char16_t (&)[Size]) -> fixed_string<char16_t, Size>;
+
+template <std::size_t Size>
+fixed_string(const char32_t (&)[Size]) -> fixed_string<char32_t, Size>;
+
+// The character type used by the formatters for a format string.
+//
+// The Standard library only provides formatters for char and wchar_t. The
+// other character types use the char formatters, which write UTF-8. Their
+// output is converted to the character type of the format string while it is
+// written, see transcoding_iterator.
+template <class CharT> struct formatter_char {
+  using type = CharT;
+};
+
+template <> struct formatter_char<char8_t> {
+  using type = char;
+};
+
+template <> struct formatter_char<char16_t> {
+  using type = char;
+};
+
+template <> struct formatter_char<char32_t> {
+  using type = char;
+};
+
+template <class CharT>
+using formatter_char_t = typename formatter_char<CharT>::type;
+
+// Returns the format string as used by the formatters.
+//
+// Every code unit is converted to one code unit of formatter_char_t. This
+// keeps the offsets of the format-specs identical. Since char8_t and char
+// have the same representation UTF-8 is kept intact. For UTF-16 and UTF-32
+// only ASCII is preserved, other code units are replaced by an UTF-8
+// continuation code unit, which is rejected as fill character.
+template <fixed_string fmt> consteval auto formatter_format_string() {
+  using CharT = typename decltype(fmt)::char_type;
+  using FCharT = formatter_char_t<CharT>;
+  if constexpr (std::same_as<CharT, FCharT>)
+    return fmt;
+  else {
+    FCharT buffer[fmt.size() + 1];
+    for (std::size_t i = 0; i != fmt.size() + 1; ++i) {
+      auto c = static_cast<std::uint32_t>(fmt[i]);
+      buffer[i] = sizeof(CharT) == 1 || c < 0x80 ? static_cast<FCharT>(c)
+                                                 : FCharT(0x80);
+    }
+    return fixed_string<FCharT, fmt.size() + 1>{buffer};
+  }
+}
+
 consteval std::string to_string(std::size_t v) {
   char buffer[20];
   return {buffer, std::to_chars(buffer, &buffer[20], v).ptr};
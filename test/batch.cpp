@@ -0,0 +1,85 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "ctf/batch.hpp"
+
+#include <boost/ut.hpp>
+
+#include <array>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace {
+
+boost::ut::suite<"batch"> batch = [] {
+  using namespace boost::ut;
+  using namespace std::literals::string_view_literals;
+
+  "rows"_test = [] {
+    std::vector<std::tuple<int, bool>> rows{{1, true}, {2, false}, {3, true}};
+
+    // The output of a row is bounded.
+    std::string output = "header\n";
+    ctf::format_batch<"{:>3},{}\n">(output, rows);
+    expect(eq(output, "header\n  1,true\n  2,false\n  3,true\n"sv));
+
+    // The output of a row is not bounded.
+    std::vector<std::pair<std::string, double>> prices{{"apple", 0.5},
+                                                        {"pear", 1.25}};
+    output.clear();
+    ctf::format_batch<"{}={}\n">(output, prices);
+    expect(eq(output, "apple=0.5\npear=1.25\n"sv));
+
+    output.clear();
+    ctf::format_batch<"{}\n">(output, std::vector<std::tuple<int>>{});
+    expect(output.empty());
+  };
+
+  "columns"_test = [] {
+    std::vector<int> ids{1, 2, 3};
+    std::array<std::string_view, 3> names{"one", "two", "three"};
+
+    std::string output;
+    ctf::format_columns<"{1}:{0:x};">(output, ids, names);
+    expect(eq(output, "one:1;two:2;three:3;"sv));
+
+    std::vector<char> separators{'a', 'b'};
+    expect(throws<std::invalid_argument>(
+        [&] { ctf::format_columns<"{}{}">(output, ids, separators); }));
+  };
+
+  "offsets"_test = [] {
+    std::vector<std::tuple<int>> rows{{1}, {22}, {333}};
+
+    ctf::batch_output output;
+    ctf::format_batch<"{}|">(output, rows);
+    expect(eq(output.text, "1|22|333|"sv));
+    expect(output.offsets == std::vector<std::size_t>{2, 5, 9});
+
+    // A second batch is appended.
+    std::vector<std::string> names{"a", "bc"};
+    ctf::format_columns<"{};">(output, names);
+    expect(eq(output.text, "1|22|333|a;bc;"sv));
+    expect(output.offsets == std::vector<std::size_t>{2, 5, 9, 11, 14});
+  };
+
+  "exception"_test = [] {
+    std::vector<std::tuple<int, int>> rows{{1, 2}, {3, -1}, {4, 5}};
+
+    ctf::batch_output output;
+    expect(throws<std::format_error>(
+        [&] { ctf::format_batch<"{:{}};">(output, rows); }));
+    expect(eq(output.text, " 1;"sv));
+    expect(output.offsets == std::vector<std::size_t>{3});
+  };
+};
+
+} // namespace
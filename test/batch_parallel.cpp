@@ -0,0 +1,86 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "ctf/batch_parallel.hpp"
+
+#include <boost/ut.hpp>
+
+#include <format>
+#include <numeric>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+namespace {
+
+std::vector<std::tuple<int, std::string>> make_rows(std::size_t size) {
+  std::vector<std::tuple<int, std::string>> result;
+  for (std::size_t i = 0; i != size; ++i)
+    result.emplace_back(i, std::string(i % 7, 'x'));
+  return result;
+}
+
+boost::ut::suite<"batch_parallel"> batch_parallel = [] {
+  using namespace boost::ut;
+  using namespace std::literals::string_view_literals;
+
+  "chunks"_test = [] {
+    auto rows = make_rows(10'000);
+    std::string expected;
+    ctf::format_batch<"{}:{}\n">(expected, rows);
+
+    std::vector<std::string> chunks =
+        ctf::format_batch_chunks<"{}:{}\n">(rows, 4);
+    expect(eq(chunks.size(), 4u));
+    expect(eq(std::accumulate(chunks.begin(), chunks.end(), std::string{}),
+              expected));
+
+    // Small batches are formatted by one thread.
+    chunks = ctf::format_batch_chunks<"{}:{}\n">(make_rows(10), 4);
+    expect(eq(chunks.size(), 1u));
+  };
+
+  "string"_test = [] {
+    auto rows = make_rows(10'000);
+    std::string expected = "header\n";
+    ctf::format_batch<"{:>5}|{}\n">(expected, rows);
+
+    std::string output = "header\n";
+    ctf::format_batch_parallel<"{:>5}|{}\n">(output, rows, 3);
+    expect(eq(output, expected));
+
+    output.clear();
+    ctf::format_batch_parallel<"{}\n">(output, make_rows(0));
+    expect(output.empty());
+  };
+
+  "offsets"_test = [] {
+    auto rows = make_rows(5'000);
+    ctf::batch_output expected;
+    ctf::format_batch<"{}{}">(expected, rows);
+    ctf::format_batch<"{}{}">(expected, rows);
+
+    ctf::batch_output output;
+    ctf::format_batch_parallel<"{}{}">(output, rows, 4);
+    ctf::format_batch_parallel<"{}{}">(output, rows, 4);
+    expect(eq(output.text, expected.text));
+    expect(output.offsets == expected.offsets);
+  };
+
+  "exception"_test = [] {
+    std::vector<std::tuple<int, int>> rows(5'000, {1, 2});
+    rows[4'000] = {1, -1};
+
+    std::string output = "unchanged";
+    expect(throws<std::format_error>(
+        [&] { ctf::format_batch_parallel<"{:{}}">(output, rows, 4); }));
+    expect(eq(output, "unchanged"sv));
+  };
+};
+
+} // namespace
@@ -0,0 +1,132 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "ctf/binary_log.hpp"
+
+#include <boost/ut.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <unistd.h>
+
+static_assert(ctf::capture_id<"{}", const char *> ==
+              ctf::capture_id<"{}", std::string>);
+static_assert(ctf::capture_id<"{}", int> != ctf::capture_id<"{}", unsigned>);
+static_assert(ctf::capture_id<"{}", int> != ctf::capture_id<"{} ", int>);
+
+namespace {
+
+std::vector<std::byte> read(int fd) {
+  std::vector<std::byte> result;
+  std::byte buffer[512];
+  for (ssize_t n = ::read(fd, buffer, sizeof(buffer)); n > 0;
+       n = ::read(fd, buffer, sizeof(buffer)))
+    result.insert(result.end(), buffer, buffer + n);
+  return result;
+}
+
+// Decodes data and returns the output.
+std::string decode(std::span<const std::byte> data) {
+  int fds[2];
+  boost::ut::expect(::pipe(fds) == 0);
+  {
+    ctf::fd_sink out{fds[1]};
+    ctf::decode_binary_log(data, out);
+  }
+  ::close(fds[1]);
+  std::vector<std::byte> output = read(fds[0]);
+  ::close(fds[0]);
+  return {reinterpret_cast<const char *>(output.data()), output.size()};
+}
+
+boost::ut::suite<"binary_log"> binary_log = [] {
+  using namespace boost::ut;
+  using namespace std::literals::string_view_literals;
+
+  "capture and decode"_test = [] {
+    int fds[2];
+    expect(::pipe(fds) == 0);
+    {
+      ctf::binary_log log{fds[1]};
+      std::string world = "world";
+      ctf::capture<"hello {}\n">(log, world);
+      ctf::capture<"{:#x} {} {:.2f}\n">(log, 42, true, 3.14159);
+      ctf::capture<"hello {}\n">(log, "literal");
+    }
+    ::close(fds[1]);
+    std::vector<std::byte> data = read(fds[0]);
+    ::close(fds[0]);
+
+    expect(eq(decode(data), "hello world\n0x2a true 3.14\nhello literal\n"sv));
+  };
+
+  "unknown record"_test = [] {
+    std::vector<std::byte> data(8 + 2 * sizeof(std::uint64_t) + 3);
+    std::memcpy(data.data(), "CTF-BIN1", 8);
+    std::uint64_t header[2] = {0x1234, 3};
+    std::memcpy(&data[8], header, sizeof(header));
+    expect(eq(decode(data), "<unknown record 0000000000001234>\n"sv));
+  };
+
+  "invalid data"_test = [] {
+    // Nothing is written before the error is detected.
+    ctf::fd_sink out{-1};
+
+    std::vector<std::byte> data(8);
+    expect(throws<std::runtime_error>(
+        [&] { ctf::decode_binary_log(data, out); }));
+
+    std::memcpy(data.data(), "CTF-BIN1", 8);
+    data.resize(12);
+    expect(throws<std::runtime_error>(
+        [&] { ctf::decode_binary_log(data, out); }));
+  };
+
+  "corrupt record"_test = [] {
+    ctf::fd_sink out{-1};
+    std::vector<std::byte> data(8 + 2 * sizeof(std::uint64_t) +
+                                sizeof(std::size_t) + 3);
+    std::memcpy(data.data(), "CTF-BIN1", 8);
+    std::uint64_t header[2] = {ctf::capture_id<"hello {}\n", std::string>,
+                               sizeof(std::size_t) + 3};
+    std::memcpy(&data[8], header, sizeof(header));
+
+    // The size of the string is larger than the record.
+    std::size_t size = 4;
+    std::memcpy(&data[8 + sizeof(header)], &size, sizeof(size));
+    expect(throws<std::runtime_error>(
+        [&] { ctf::decode_binary_log(data, out); }));
+
+    size = std::size_t(-1);
+    std::memcpy(&data[8 + sizeof(header)], &size, sizeof(size));
+    expect(throws<std::runtime_error>(
+        [&] { ctf::decode_binary_log(data, out); }));
+
+    // The record is too small for the size of the string.
+    header[1] = sizeof(std::size_t) - 1;
+    std::memcpy(&data[8], header, sizeof(header));
+    data.resize(8 + sizeof(header) + sizeof(std::size_t) - 1);
+    expect(throws<std::runtime_error>(
+        [&] { ctf::decode_binary_log(data, out); }));
+
+    // The record is too small for the arguments.
+    header[0] = ctf::capture_id<"{:#x} {} {:.2f}\n", int, bool, double>;
+    header[1] = sizeof(int) + sizeof(bool);
+    std::memcpy(&data[8], header, sizeof(header));
+    data.resize(8 + sizeof(header) + sizeof(int) + sizeof(bool));
+    expect(throws<std::runtime_error>(
+        [&] { ctf::decode_binary_log(data, out); }));
+  };
+};
+
+} // namespace
@@ -0,0 +1,138 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "ctf/bytes.hpp"
+#include "ctf/format.hpp"
+
+#include <boost/ut.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <format>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+std::span<const unsigned char> as_bytes(std::string_view s) {
+  return {reinterpret_cast<const unsigned char *>(s.data()), s.size()};
+}
+
+// The base64 output of data, encoding one group at a time.
+std::string reference_base64(std::span<const unsigned char> data) {
+  static constexpr char alphabet[] =
+      "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  std::string result;
+  for (std::size_t i = 0; i < data.size(); i += 3) {
+    std::size_t n = std::min<std::size_t>(data.size() - i, 3);
+    std::uint32_t t = data[i] << 16;
+    if (n > 1)
+      t |= data[i + 1] << 8;
+    if (n > 2)
+      t |= data[i + 2];
+    result += alphabet[t >> 18];
+    result += alphabet[(t >> 12) & 0x3f];
+    result += n > 1 ? alphabet[(t >> 6) & 0x3f] : '=';
+    result += n > 2 ? alphabet[t & 0x3f] : '=';
+  }
+  return result;
+}
+
+std::string reference_hex(std::span<const unsigned char> data) {
+  std::string result;
+  for (unsigned char c : data) {
+    char buffer[3];
+    std::snprintf(buffer, sizeof(buffer), "%02x", c);
+    result += buffer;
+  }
+  return result;
+}
+
+boost::ut::suite<"bytes"> bytes = [] {
+  using namespace boost::ut;
+  using namespace std::literals::string_view_literals;
+
+  static constexpr std::array<unsigned char, 5> data{0xde, 0xad, 0xbe, 0xef,
+                                                     0x01};
+
+  "hex"_test = [] {
+    expect(eq(ctf::format<"{}">(ctf::bytes(data)), "deadbeef01"sv));
+    expect(eq(ctf::format<"{:x}">(ctf::bytes(data)), "deadbeef01"sv));
+    expect(eq(ctf::format<"{:X}">(ctf::bytes(data)), "DEADBEEF01"sv));
+    expect(eq(ctf::format<"[{}]">(ctf::bytes(std::span<const std::byte>{})),
+              "[]"sv));
+
+    std::vector<std::byte> v{std::byte{0x0f}, std::byte{0xf0}};
+    expect(eq(ctf::format<"{}">(ctf::bytes(v)), "0ff0"sv));
+  };
+
+  "separator"_test = [] {
+    expect(eq(ctf::format<"{::X}">(ctf::bytes(data)), "DE:AD:BE:EF:01"sv));
+    expect(eq(ctf::format<"{: 2x}">(ctf::bytes(data)), "dead beef 01"sv));
+    expect(eq(ctf::format<"{:-4}">(ctf::bytes(data)), "deadbeef-01"sv));
+    expect(eq(ctf::format<"{:,8x}">(ctf::bytes(data)), "deadbeef01"sv));
+  };
+
+  "base64"_test = [] {
+    expect(eq(ctf::format<"{:b}">(ctf::bytes(as_bytes(""))), ""sv));
+    expect(eq(ctf::format<"{:b}">(ctf::bytes(as_bytes("f"))), "Zg=="sv));
+    expect(eq(ctf::format<"{:b}">(ctf::bytes(as_bytes("fo"))), "Zm8="sv));
+    expect(eq(ctf::format<"{:b}">(ctf::bytes(as_bytes("foo"))), "Zm9v"sv));
+    expect(eq(ctf::format<"{:b}">(ctf::bytes(as_bytes("foobar"))),
+              "Zm9vYmFy"sv));
+  };
+
+  "hexdump"_test = [] {
+    expect(eq(ctf::format<"{:h}">(
+                  ctf::bytes(as_bytes("hello, world\nABCDEFGHIJKLMNOPQRST"))),
+              "00000000  68 65 6c 6c 6f 2c 20 77  6f 72 6c 64 0a 41 42 43  "
+              "|hello, world.ABC|\n"
+              "00000010  44 45 46 47 48 49 4a 4b  4c 4d 4e 4f 50 51 52 53  "
+              "|DEFGHIJKLMNOPQRS|\n"
+              "00000020  54                                                "
+              "|T|\n"sv));
+  };
+
+  "blocks"_test = [] {
+    // Every size around the blocks converted at once and the buffer size.
+    std::vector<unsigned char> v(2000);
+    for (std::size_t i = 0; i != v.size(); ++i)
+      v[i] = (i * 7919 + 13) & 0xff;
+    for (std::size_t size = 0; size < v.size(); size += size < 100 ? 1 : 37) {
+      std::span<const unsigned char> s{v.data(), size};
+      expect(eq(ctf::format<"{}">(ctf::bytes(s)), reference_hex(s)));
+      expect(eq(ctf::format<"{:b}">(ctf::bytes(s)), reference_base64(s)));
+      expect(eq(ctf::format<"{::}">(ctf::bytes(s)).size(),
+                size == 0 ? 0 : 3 * size - 1));
+      expect(eq(ctf::format<"{:h}">(ctf::bytes(s)).size(),
+                size / 16 * 79 + (size % 16 ? 63 + size % 16 : 0)));
+    }
+  };
+
+  "runtime"_test = [] {
+    expect(eq(std::format("{::X}", ctf::bytes(data)), "DE:AD:BE:EF:01"sv));
+    ctf::bytes_view value = ctf::bytes(data);
+    expect(throws(
+        [&] { (void)std::vformat("{:b:}", std::make_format_args(value)); }));
+  };
+
+  "valid"_test = [] {
+    expect(ctf::valid<"{: 4X}", ctf::bytes_view>);
+    expect(!ctf::valid<"{:4X}", ctf::bytes_view>);
+    expect(!ctf::valid<"{: 0x}", ctf::bytes_view>);
+    expect(!ctf::valid<"{::b}", ctf::bytes_view>);
+    expect(!ctf::valid<"{:h:}", ctf::bytes_view>);
+    expect(!ctf::valid<"{:d}", ctf::bytes_view>);
+  };
+};
+
+} // namespace
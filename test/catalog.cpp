@@ -0,0 +1,54 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "ctf/catalog.hpp"
+
+#include <boost/ut.hpp>
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+namespace {
+
+boost::ut::suite<"catalog"> catalog = [] {
+  using namespace boost::ut;
+  using namespace std::literals::string_view_literals;
+
+  using messages =
+      ctf::catalog<"{} files copied to {}", "{1}: {0} Dateien kopiert",
+                   "{0:>4} fichiers copiés vers {1:?}">;
+
+  "format"_test = [] {
+    expect(eq(messages::size, 3u));
+    expect(eq(messages::format(0, 3, "/tmp"sv), "3 files copied to /tmp"sv));
+    expect(eq(messages::format(1, 3, "/tmp"sv), "/tmp: 3 Dateien kopiert"sv));
+    expect(eq(messages::format(2, 3, std::string{"/tmp"}),
+              "   3 fichiers copiés vers \"/tmp\""sv));
+  };
+
+  "sink"_test = [] {
+    std::string output;
+    ctf::string_sink sink{output};
+    messages::format_to(sink, 1, 42, "/home");
+    expect(eq(output, "/home: 42 Dateien kopiert"sv));
+  };
+
+  "invalid language"_test = [] {
+    expect(throws<std::out_of_range>([] { messages::format(3, 1, "x"); }));
+  };
+
+  "valid"_test = [] {
+    expect(messages::valid<int, std::string_view>);
+    // The precision of the second translation is invalid for an int.
+    expect(!ctf::catalog<"{0}", "{0:.2}">::valid<int>);
+    // The translations use two arguments.
+    expect(!messages::valid<int>);
+  };
+};
+
+} // namespace
@@ -0,0 +1,88 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "ctf/format.hpp"
+
+#include <boost/ut.hpp>
+
+#include <string>
+#include <string_view>
+
+static_assert(ctf::valid<L"{}", int>);
+static_assert(ctf::valid<L"{}", const wchar_t *>);
+static_assert(!ctf::valid<L"{}", const char *>);
+static_assert(!ctf::valid<L"{:+}", std::wstring_view>);
+
+static_assert(ctf::valid<u8"{}", const char8_t *>);
+static_assert(ctf::valid<u8"{}", std::u8string>);
+static_assert(ctf::valid<u8"{}", std::string_view>);
+
+static_assert(ctf::valid<u"{}", std::string_view>);
+static_assert(!ctf::valid<u"{}", std::u16string_view>);
+static_assert(ctf::valid<U"{}", const char8_t *>);
+static_assert(!ctf::valid<U"{}", std::u32string_view>);
+
+namespace {
+
+boost::ut::suite<"format wchar_t"> format_wchar_t = [] {
+  using namespace boost::ut;
+  using namespace std::literals::string_view_literals;
+
+  expect(ctf::format<L"">() == L""sv);
+  expect(ctf::format<L"hello {{world}}">() == L"hello {world}"sv);
+  expect(ctf::format<L"answer {}">(42) == L"answer 42"sv);
+  expect(ctf::format<L"{:+#06x}">(42) == L"+0x02a"sv);
+  expect(ctf::format<L"{} {}">(true, 'a') == L"true a"sv);
+  expect(ctf::format<L"{} {}">(L'a', nullptr) == L"a 0x0"sv);
+
+  std::wstring world = L"world";
+  expect(ctf::format<L"hello {}">(world) == L"hello world"sv);
+  expect(ctf::format<L"hello {:_^9}">(world) == L"hello __world__"sv);
+  expect(ctf::format<L"hello {:.3}">(L"world") == L"hello wor"sv);
+  expect(ctf::format<L"hello {:\u3000>7}">(world) ==
+         L"hello \u3000\u3000world"sv);
+  expect(ctf::format<L"hello {:\U0001F600>6}">(world) ==
+         L"hello \U0001F600world"sv);
+  expect(ctf::format<L"hello {0:$>{1}}">(world, 6) == L"hello $world"sv);
+};
+
+boost::ut::suite<"format char8_t"> format_char8_t = [] {
+  using namespace boost::ut;
+  using namespace std::literals::string_view_literals;
+
+  expect(ctf::format<u8"hellö {{}}">() == u8"hellö {}"sv);
+  expect(ctf::format<u8"answer {:x}">(42) == u8"answer 2a"sv);
+  expect(ctf::format<u8"{} {}">(u8"wörld", "ascii") == u8"wörld ascii"sv);
+  expect(ctf::format<u8"{:*^7}">(std::u8string{u8"wörld"}) ==
+         u8"*wörld*"sv);
+  expect(ctf::format<u8"{:\u3000>6}">(u8'a') ==
+         u8"\u3000\u3000\u3000\u3000\u3000a"sv);
+};
+
+boost::ut::suite<"format char16_t"> format_char16_t = [] {
+  using namespace boost::ut;
+  using namespace std::literals::string_view_literals;
+
+  expect(ctf::format<u"hellö {{}}">() == u"hellö {}"sv);
+  expect(ctf::format<u"answer {:#X}">(42) == u"answer 0X2A"sv);
+  expect(ctf::format<u"{} {}">(true, 2.5) == u"true 2.5"sv);
+  expect(ctf::format<u"{} \U0001F600">(u8"wörld \U0001F600") ==
+         u"wörld \U0001F600 \U0001F600"sv);
+  expect(ctf::format<u"{:_^9}">("wörld") == u"__wörld__"sv);
+};
+
+boost::ut::suite<"format char32_t"> format_char32_t = [] {
+  using namespace boost::ut;
+  using namespace std::literals::string_view_literals;
+
+  expect(ctf::format<U"hellö {{}}">() == U"hellö {}"sv);
+  expect(ctf::format<U"answer {:b}">(5) == U"answer 101"sv);
+  expect(ctf::format<U"{}|{:?}">(u8"\U0001F600", "\n") ==
+         U"\U0001F600|\"\\n\""sv);
+};
+
+} // namespace
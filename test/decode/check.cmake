@@ -0,0 +1,19 @@
+# Writes a binary log with WRITER and validates the output of DECODER.
+#
+# The default ctf-decode, CTF_DECODE, has none of the call sites, so it writes
+# every record as its id.
+execute_process(COMMAND ${WRITER} ${LOG} COMMAND_ERROR_IS_FATAL ANY)
+
+execute_process(COMMAND ${DECODER} ${LOG} OUTPUT_VARIABLE output
+                                          COMMAND_ERROR_IS_FATAL ANY)
+file(READ ${EXPECTED} expected)
+if(NOT output STREQUAL expected)
+  message(FATAL_ERROR "unexpected output of ${DECODER}:\n${output}")
+endif()
+
+execute_process(COMMAND ${CTF_DECODE} ${LOG} OUTPUT_VARIABLE output
+                                             COMMAND_ERROR_IS_FATAL ANY)
+if(NOT output MATCHES "^(<unknown record [0-9a-f]+>\n)+$")
+  message(FATAL_ERROR "unexpected output of ${CTF_DECODE}:\n${output}")
+endif()
+
@@ -0,0 +1,22 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+// The call sites shared by the writer and the decoder.
+
+#include "sites.hpp"
+
+#include "ctf/binary_log.hpp"
+
+#include <string>
+
+void write_log(int fd) {
+  ctf::binary_log log{fd};
+  std::string world = "world";
+  ctf::capture<"hello {}\n">(log, world);
+  ctf::capture<"{:#x} {} {:.2f}\n">(log, 42, true, 3.14159);
+  ctf::capture<"{:>5}|{:<5}|{}\n">(log, 'a', "bc", -1);
+}
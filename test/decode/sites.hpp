@@ -0,0 +1,14 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef CTF_TEST_DECODE_SITES_HPP
+#define CTF_TEST_DECODE_SITES_HPP
+
+// Writes the binary log of the call sites to fd.
+void write_log(int fd);
+
+#endif // CTF_TEST_DECODE_SITES_HPP
@@ -0,0 +1,24 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+// Writes the binary log of the call sites to the file in the first argument.
+
+#include "sites.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+int main(int argc, char **argv) {
+  if (argc != 2)
+    return 1;
+
+  int fd = ::open(argv[1], O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  if (fd < 0)
+    return 1;
+  write_log(fd);
+  return ::close(fd) != 0;
+}
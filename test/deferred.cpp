@@ -0,0 +1,96 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "ctf/deferred.hpp"
+
+#include <boost/ut.hpp>
+
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace {
+
+std::string read_available(int fd) {
+  std::string result;
+  char buffer[512];
+  for (ssize_t n = ::read(fd, buffer, sizeof(buffer)); n > 0;
+       n = ::read(fd, buffer, sizeof(buffer)))
+    result.append(buffer, n);
+  return result;
+}
+
+void decode_int(const std::byte *data, ctf::fd_sink &out) {
+  int value;
+  std::memcpy(&value, data, sizeof(value));
+  ctf::format_to<"{},">(out, value);
+}
+
+boost::ut::suite<"deferred"> deferred = [] {
+  using namespace boost::ut;
+  using namespace std::literals::string_view_literals;
+
+  "queue"_test = [] {
+    int fds[2];
+    expect(::pipe2(fds, O_NONBLOCK) == 0);
+    {
+      ctf::fd_sink out{fds[1]};
+
+      // Every record uses 32 bytes, so two records fit.
+      ctf::deferred::detail::queue queue{64,
+                                         ctf::deferred::backpressure::drop};
+      for (int i = 0; i != 6; ++i)
+        queue.push(&decode_int, sizeof(int),
+                   [i](std::byte *data) { std::memcpy(data, &i, sizeof(i)); });
+      expect(eq(queue.dropped(), 4u));
+
+      expect(queue.drain(out));
+      expect(!queue.drain(out));
+      expect(queue.empty());
+
+      // Wraps around the end of the buffer.
+      for (int i = 10; i != 16; ++i) {
+        queue.push(&decode_int, sizeof(int),
+                   [i](std::byte *data) { std::memcpy(data, &i, sizeof(i)); });
+        queue.drain(out);
+      }
+
+      // Records larger than half the queue are discarded.
+      expect(!queue.push(&decode_int, 64, [](std::byte *) {}));
+    }
+    ::close(fds[1]);
+    expect(eq(read_available(fds[0]), "0,1,10,11,12,13,14,15,"sv));
+    ::close(fds[0]);
+  };
+
+  "log"_test = [] {
+    int fds[2];
+    expect(::pipe2(fds, O_NONBLOCK) == 0);
+    ctf::deferred::configure({.fd = fds[1]});
+
+    std::string world = "world";
+    expect(ctf::deferred::log<"hello {}\n">(world));
+    world = "changed";
+    expect(ctf::deferred::log<"{:#x} {} {:>6.2f}\n">(42, true, 3.14159));
+    expect(ctf::deferred::log<"{} {}\n">("literal", 'c'));
+    std::thread{[] { ctf::deferred::log<"thread {}\n">(1); }}.join();
+    ctf::deferred::flush();
+
+    expect(eq(read_available(fds[0]),
+              "hello world\n0x2a true   3.14\nliteral c\nthread 1\n"sv));
+    expect(eq(ctf::deferred::dropped(), 0u));
+
+    expect(throws<std::logic_error>([] { ctf::deferred::configure({}); }));
+  };
+};
+
+} // namespace
@@ -9,7 +9,12 @@
 //
 // Validates the hand-crafted static_assert messages.
 
+#include "ctf/binary_log.hpp"
+#include "ctf/deferred.hpp"
 #include "ctf/format.hpp"
+#include "ctf/text_template.hpp"
+
+#include <span>
 
 enum class not_formattable {};
 
@@ -351,4 +356,91 @@ arg-id not closed {0:{1s}}{{.*}}\
 }}
   // expected-note@+1 {{in instantiation of function template specialization}}
   (void)ctf::format<"arg-id not closed {0:{1s}}">(std::string_view{}, 42);
+
+  // expected-error-re@*:* {{static assertion failed due to requirement '!"unbounded output"':{{.*}}\
+the output of the replacement-field has no upper limit{{.*}}\
+unbounded {:{}}{{.*}}\
+          ~^{{.*}}\
+}}
+  // expected-note@+1 {{in instantiation of function template specialization}}
+  (void)ctf::format_inplace<"unbounded {:{}}">(42, 10);
+
+  // expected-error-re@*:* {{static assertion failed due to requirement '!"unbounded output"':{{.*}}\
+the output of the replacement-field has no upper limit{{.*}}\
+string {:.5}{{.*}}\
+       ~^{{.*}}\
+}}
+  // expected-note@+1 {{in instantiation of function template specialization}}
+  (void)ctf::format_inplace<"string {:.5}">(std::string_view{});
+
+  // expected-error-re@*:* {{static assertion failed due to requirement '!"unbounded output"':{{.*}}\
+the output of the replacement-field has no upper limit{{.*}}\
+bool {:L}{{.*}}\
+     ~^{{.*}}\
+}}
+  // expected-note@+1 {{in instantiation of function template specialization}}
+  (void)ctf::format_inplace<"bool {:L}">(true);
+
+  // The memory of a span is not copied in the log.
+  // expected-error-re@*:* {{static assertion failed due to requirement '!"unsupported argument"': the arguments need to be strings, arithmetic types, enumerations, or void pointers}}
+  // expected-note@+3 {{in instantiation of function template specialization}}
+  ctf::binary_log log{-1};
+  int values[] = {1, 2, 3};
+  ctf::capture<"span {}">(log, std::span<const int>{values});
+
+  // The worker formats the span after the memory may be released.
+  // expected-error-re@*:* {{static assertion failed due to requirement '!"unsupported argument"': the arguments need to be strings, arithmetic types, enumerations, or void pointers}}
+  // expected-note@+1 {{in instantiation of function template specialization}}
+  (void)ctf::deferred::log<"span {}">(std::span<const int>{values});
+
+  // expected-error-re@*:* {{static assertion failed due to requirement '!"parse error"':{{.*}}\
+the closing tag has no matching opening tag{{.*}}\
+text {/a}{{.*}}\
+     ~~^{{.*}}\
+}}
+  // expected-note@+1 {{in instantiation of function template specialization}}
+  (void)ctf::render<"text {/a}">(ctf::arg<"a">(1));
+
+  // expected-error-re@*:* {{static assertion failed due to requirement '!"parse error"':{{.*}}\
+the closing tag does not match the opening tag at 0{{.*}}\
+{#a}{/b}{{.*}}\
+    ~~^{{.*}}\
+}}
+  // expected-note@+1 {{in instantiation of function template specialization}}
+  (void)ctf::render<"{#a}{/b}">(ctf::arg<"a">(values), ctf::arg<"b">(values));
+
+  // expected-error-re@*:* {{static assertion failed due to requirement '!"parse error"':{{.*}}\
+the tag has no closing tag{{.*}}\
+{#a}text{{.*}}\
+~~~^{{.*}}\
+}}
+  // expected-note@+1 {{in instantiation of function template specialization}}
+  (void)ctf::render<"{#a}text">(ctf::arg<"a">(values));
+
+  // expected-error-re@*:* {{static assertion failed due to requirement '!"parse error"':{{.*}}\
+there is no argument with this name{{.*}}\
+hello {name}{{.*}}\
+      ~^{{.*}}\
+}}
+  // expected-note@+1 {{in instantiation of function template specialization}}
+  (void)ctf::render<"hello {name}">();
+
+  // expected-error-re@*:* {{static assertion failed due to requirement '!"template error"':{{.*}}\
+the current element is only available in the body of a section{{.*}}\
+item {.}{{.*}}\
+     ^~~{{.*}}\
+}}
+  // expected-note@+1 {{in instantiation of function template specialization}}
+  (void)ctf::render<"item {.}">();
+
+  // expected-error-re@*:* {{static assertion failed due to requirement '!"template error"':{{.*}}\
+the value of a section needs to be a range{{.*}}\
+{#a}{/a}{{.*}}\
+^~~~{{.*}}\
+}}
+  // expected-note@+1 {{in instantiation of function template specialization}}
+  (void)ctf::render<"{#a}{/a}">(ctf::arg<"a">(42));
+
+  // The errors of the templates are found while rendering.
+  // expected-note-re@*:* 0+ {{in instantiation of function template specialization '{{ctf::detail|std::__for_each_index_sequence}}}}
 }
@@ -0,0 +1,87 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "ctf/format.hpp"
+#include "ctf/text_template.hpp"
+
+#include <boost/ut.hpp>
+
+#include <string>
+#include <string_view>
+
+namespace {
+
+// The escaped output of s, escaping one code unit at a time.
+template <ctf::escape_kind kind> std::string reference(std::string_view s) {
+  std::string result;
+  char buffer[6];
+  for (unsigned char c : s)
+    if (ctf::detail::needs_escape<kind>(c))
+      result += ctf::detail::escape_sequence<kind>(c, buffer);
+    else
+      result += char(c);
+  return result;
+}
+
+boost::ut::suite<"escape"> escape = [] {
+  using namespace boost::ut;
+  using namespace std::literals::string_view_literals;
+
+  "json"_test = [] {
+    expect(eq(ctf::format<"\"{:j}\"">("a \"b\"\\\n\t\x01"sv),
+              "\"a \\\"b\\\"\\\\\\n\\t\\u0001\""sv));
+    expect(eq(ctf::format<"{:j}">("café"), "café"sv));
+  };
+
+  "html"_test = [] {
+    expect(eq(ctf::format<"<p title='{0:h}'>{0:h}</p>">("<a & 'b'>\""sv),
+              "<p title='&lt;a &amp; &#39;b&#39;&gt;&quot;'>"
+              "&lt;a &amp; &#39;b&#39;&gt;&quot;</p>"sv));
+  };
+
+  "url"_test = [] {
+    expect(eq(ctf::format<"?q={:u}">(std::string{"a b/cü-._~"}),
+              "?q=a%20b%2Fc%C3%BC-._~"sv));
+  };
+
+  "width"_test = [] {
+    // The padding is based on the escaped string.
+    expect(eq(ctf::format<"[{:*>12h}]">("<a>"), "[***&lt;a&gt;]"sv));
+    expect(eq(ctf::format<"[{:{}j}]">("\n", 4), "[\\n  ]"sv));
+  };
+
+  "blocks"_test = [] {
+    // Every position in and around the blocks classified at once.
+    for (std::size_t size : {15u, 16u, 17u, 31u, 32u, 33u, 100u})
+      for (std::size_t i = 0; i != size; ++i)
+        for (char c : {'"', '\n', '<', '&', ' ', '/', '\x7f', '\xc3'}) {
+          std::string s(size, 'x');
+          s[i] = c;
+          expect(eq(ctf::format<"{:j}">(s),
+                    reference<ctf::escape_kind::json>(s)));
+          expect(eq(ctf::format<"{:h}">(s),
+                    reference<ctf::escape_kind::html>(s)));
+          expect(eq(ctf::format<"{:u}">(s),
+                    reference<ctf::escape_kind::url>(s)));
+        }
+  };
+
+  "text template"_test = [] {
+    expect(eq(ctf::render<"<b>{name:h}</b>">(ctf::arg<"name">("<i>"sv)),
+              "<b>&lt;i&gt;</b>"sv));
+  };
+
+  "valid"_test = [] {
+    expect(ctf::valid<"{:j}", std::string>);
+    expect(ctf::valid<"{:>10h}", const char *>);
+    expect(!ctf::valid<"{:sj}", std::string>);
+    expect(!ctf::valid<"{:.3j}", std::string>);
+    expect(!ctf::valid<"{:jj}", std::string>);
+  };
+};
+
+} // namespace
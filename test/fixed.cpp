@@ -0,0 +1,77 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "ctf/fixed.hpp"
+#include "ctf/format.hpp"
+
+#include <boost/ut.hpp>
+
+#include <cstdint>
+#include <format>
+#include <limits>
+#include <string_view>
+
+namespace {
+
+boost::ut::suite<"fixed"> fixed = [] {
+  using namespace boost::ut;
+  using namespace std::literals::string_view_literals;
+
+  "fraction"_test = [] {
+    expect(eq(ctf::format<"{}">(ctf::fixed<2>(12345)), "123.45"sv));
+    expect(eq(ctf::format<"{}">(ctf::fixed<2>(5)), "0.05"sv));
+    expect(eq(ctf::format<"{}">(ctf::fixed<2>(-5)), "-0.05"sv));
+    expect(eq(ctf::format<"{}">(ctf::fixed<0>(-42)), "-42"sv));
+    expect(eq(ctf::format<"{}">(ctf::fixed<6>(1'500'000)), "1.500000"sv));
+    expect(eq(ctf::format<"{}">(ctf::fixed<3>(0)), "0.000"sv));
+  };
+
+  "limits"_test = [] {
+    expect(eq(ctf::format<"{}">(
+                  ctf::fixed<18>(std::numeric_limits<std::int64_t>::min())),
+              "-9.223372036854775808"sv));
+    expect(eq(ctf::format<"{:,}">(
+                  ctf::fixed<0>(std::numeric_limits<std::int64_t>::max())),
+              "9,223,372,036,854,775,807"sv));
+  };
+
+  "sign"_test = [] {
+    expect(eq(ctf::format<"{:+}">(ctf::fixed<1>(15)), "+1.5"sv));
+    expect(eq(ctf::format<"{: }">(ctf::fixed<1>(15)), " 1.5"sv));
+    expect(eq(ctf::format<"{:+}">(ctf::fixed<1>(-15)), "-1.5"sv));
+  };
+
+  "grouping"_test = [] {
+    expect(eq(ctf::format<"{:,}">(ctf::fixed<2>(123456789)), "1,234,567.89"sv));
+    expect(eq(ctf::format<"{:_}">(ctf::fixed<2>(-100000)), "-1_000.00"sv));
+    expect(eq(ctf::format<"{:,}">(ctf::fixed<2>(99999)), "999.99"sv));
+  };
+
+  "width"_test = [] {
+    expect(eq(ctf::format<"[{:8}]">(ctf::fixed<2>(150)), "[    1.50]"sv));
+    expect(eq(ctf::format<"[{:*<8}]">(ctf::fixed<2>(150)), "[1.50****]"sv));
+    expect(eq(ctf::format<"[{:^9}]">(ctf::fixed<2>(150)), "[  1.50   ]"sv));
+    expect(eq(ctf::format<"[{:08}]">(ctf::fixed<2>(-150)), "[-0001.50]"sv));
+    expect(eq(ctf::format<"[{:+{}}]">(ctf::fixed<2>(150), 6), "[ +1.50]"sv));
+    expect(eq(ctf::format<"[{:2}]">(ctf::fixed<2>(150)), "[1.50]"sv));
+  };
+
+  "runtime"_test = [] {
+    expect(eq(std::format("{:>+10,}", ctf::fixed<2>(123456)),
+              " +1,234.56"sv));
+  };
+
+  "valid"_test = [] {
+    expect(ctf::valid<"{:*>+012_}", ctf::fixed_point<2>>);
+    expect(!ctf::valid<"{:.2}", ctf::fixed_point<2>>);
+    expect(!ctf::valid<"{:#}", ctf::fixed_point<2>>);
+    expect(!ctf::valid<"{:f}", ctf::fixed_point<2>>);
+    expect(!ctf::valid<"{:,,}", ctf::fixed_point<2>>);
+  };
+};
+
+} // namespace
@@ -0,0 +1,128 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "ctf/flight_recorder.hpp"
+
+#include <boost/ut.hpp>
+
+#include <atomic>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+
+boost::ut::suite<"flight_recorder"> flight_recorder = [] {
+  using namespace boost::ut;
+  using namespace std::literals::string_view_literals;
+
+  "messages"_test = [] {
+    ctf::flight_recorder recorder{4096};
+    expect(eq(recorder.capacity(), 4096u));
+    expect(recorder.snapshot().empty());
+
+    // Bounded output is formatted directly in the slot.
+    ctf::format_to<"answer {:#x}">(recorder, 42);
+    // Unbounded output is formatted in a scratch buffer first.
+    ctf::format_to<"hello {}">(recorder, "world");
+
+    std::vector<std::string> messages = recorder.snapshot();
+    expect(eq(messages.size(), 2u));
+    expect(eq(messages[0], "answer 0x2a"sv));
+    expect(eq(messages[1], "hello world"sv));
+  };
+
+  "overwrite"_test = [] {
+    ctf::flight_recorder recorder{4096};
+    for (int i = 0; i != 1000; ++i)
+      ctf::format_to<"message {}">(recorder, i);
+
+    std::vector<std::string> messages = recorder.snapshot();
+    expect(!messages.empty());
+    expect(eq(messages.back(), "message 999"sv));
+    // The most recent messages are retained in order.
+    for (std::size_t i = 1; i < messages.size(); ++i)
+      expect(eq(std::stoi(messages[i].substr(8)),
+                std::stoi(messages[i - 1].substr(8)) + 1));
+  };
+
+  "truncation"_test = [] {
+    ctf::flight_recorder recorder{4096};
+    std::string text(4096, 'x');
+    ctf::format_to<"{}">(recorder, text);
+
+    std::vector<std::string> messages = recorder.snapshot();
+    expect(eq(messages.size(), 1u));
+    expect(eq(messages[0].size(), recorder.max_message_size()));
+  };
+
+  "concurrent"_test = [] {
+    ctf::flight_recorder recorder{64 * 1024};
+    std::vector<std::thread> threads;
+    for (int t = 0; t != 4; ++t)
+      threads.emplace_back([&recorder, t] {
+        for (int i = 0; i != 50'000; ++i)
+          ctf::format_to<"{}{:{}}">(recorder, t, "", i % 50 + 1);
+      });
+
+    // Every message in a snapshot is complete.
+    auto validate = [](const std::vector<std::string> &messages) {
+      for (const std::string &message : messages)
+        if (message.find_first_not_of(' ', 1) != std::string::npos)
+          return false;
+      return true;
+    };
+    for (int i = 0; i != 100; ++i)
+      expect(validate(recorder.snapshot()));
+
+    for (auto &thread : threads)
+      thread.join();
+    std::vector<std::string> messages = recorder.snapshot();
+    expect(!messages.empty());
+    expect(validate(messages));
+  };
+
+  "concurrent wrap"_test = [] {
+    // A few large messages fill the ring, so the writers overwrite the slots
+    // a snapshot is reading.
+    ctf::flight_recorder recorder{16 * 1024};
+    std::atomic<bool> done{false};
+    std::vector<std::thread> threads;
+    for (int t = 0; t != 4; ++t)
+      threads.emplace_back([&recorder, &done, t] {
+        for (int i = 0; !done.load(std::memory_order_relaxed); ++i)
+          // Bounded output is formatted directly in the slot.
+          ctf::format_to<"{}{:999}">(recorder, t, i);
+      });
+
+    // Every message in a snapshot is complete.
+    auto validate = [](const std::vector<std::string> &messages) {
+      for (const std::string &message : messages) {
+        if (message.size() != 1000 || message[0] < '0' || message[0] > '3')
+          return false;
+        std::size_t digits = message.find_first_not_of(' ', 1);
+        if (digits == std::string::npos ||
+            message.find_first_not_of("0123456789", digits) !=
+                std::string::npos)
+          return false;
+      }
+      return true;
+    };
+    for (int i = 0; i != 1000; ++i)
+      expect(validate(recorder.snapshot()));
+
+    done = true;
+    for (auto &thread : threads)
+      thread.join();
+    std::vector<std::string> messages = recorder.snapshot();
+    expect(!messages.empty());
+    expect(validate(messages));
+  };
+};
+
+} // namespace
@@ -519,4 +519,22 @@ boost::ut::suite<"format ranges"> format_ranges = [] {
       "{\"key\": \"value\"}"sv));
 };
 
+boost::ut::suite<"format exact"> format_exact = [] {
+  using namespace boost::ut;
+  using namespace std::literals::string_view_literals;
+
+  expect(eq(ctf::format_exact<"">(), ""sv));
+  expect(eq(ctf::format_exact<"answer {}">(42), "answer 42"sv));
+
+  std::string s = ctf::format_exact<"Checked out {} items for a total of {}.">(
+      42, "a lot of money, more than fits in the small string buffer");
+  expect(eq(s, "Checked out 42 items for a total of a lot of money, more than "
+               "fits in the small string buffer."sv));
+  expect(s.capacity() <= ctf::format<"{}">(s).capacity());
+
+  // The output no longer fits in the stack buffer.
+  std::string large(2 * ctf::scratch_buffer_size, 'x');
+  expect(eq(ctf::format_exact<"[{}]">(large), "[" + large + "]"));
+};
+
 } // namespace
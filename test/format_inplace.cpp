@@ -0,0 +1,77 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "ctf/format.hpp"
+
+#include <boost/ut.hpp>
+
+#include <string_view>
+
+namespace {
+
+template <ctf::fixed_string fmt, class... Args>
+constexpr std::size_t capacity(Args &&...args) {
+  return decltype(ctf::format_inplace<fmt>(args...))::capacity();
+}
+
+boost::ut::suite<"format_inplace"> format_inplace = [] {
+  using namespace boost::ut;
+  using namespace std::literals::string_view_literals;
+
+  "no replacement fields"_test = [] {
+    expect(eq(ctf::format_inplace<"">().view(), ""sv));
+    expect(eq(ctf::format_inplace<"hello {{world}}">().view(),
+              "hello {world}"sv));
+    static_assert(capacity<"">() == 0);
+    static_assert(capacity<"hello {{world}}">() == 13);
+  };
+
+  "bool"_test = [] {
+    expect(eq(ctf::format_inplace<"{}">(true).view(), "true"sv));
+    expect(eq(ctf::format_inplace<"{:_>8}">(false).view(), "___false"sv));
+    static_assert(capacity<"{}">(true) == 5);
+    static_assert(capacity<"{:8}">(true) == 8);
+  };
+
+  "char"_test = [] {
+    expect(eq(ctf::format_inplace<"{}">('a').view(), "a"sv));
+    expect(eq(ctf::format_inplace<"{:?}">('\n').view(), "'\\n'"sv));
+    expect(eq(ctf::format_inplace<"{:#x}">('*').view(), "0x2a"sv));
+    static_assert(capacity<"{}">('a') == 1);
+    static_assert(capacity<"{:?}">('a') == 8);
+  };
+
+  "integral"_test = [] {
+    expect(eq(ctf::format_inplace<"{}">(42).view(), "42"sv));
+    expect(eq(ctf::format_inplace<"{}">(-2147483647 - 1).view(),
+              "-2147483648"sv));
+    expect(eq(ctf::format_inplace<"{:+#010x}">(42).view(), "+0x000002a"sv));
+    expect(eq(ctf::format_inplace<"{:#b}">(255u).view(), "0b11111111"sv));
+    expect(eq(ctf::format_inplace<"{:　>4}">(1).view(),
+              "　　　1"sv));
+
+    static_assert(capacity<"{}">(42) == 11);
+    static_assert(capacity<"{:x}">(42u) == 11);
+    static_assert(capacity<"{:#b}">(42ull) == 67);
+    static_assert(capacity<"{:20}">(42) == 20);
+    static_assert(capacity<"{:　>4}">(42) == 12);
+  };
+
+  "pointer"_test = [] {
+    expect(eq(ctf::format_inplace<"{}">(nullptr).view(), "0x0"sv));
+    static_assert(capacity<"{}">(nullptr) == 2 + 2 * sizeof(void *));
+  };
+
+  "protocol field"_test = [] {
+    auto field = ctf::format_inplace<"ID={:08X};LEN={:04};OK={:d}">(
+        0xC0FFEEu, 42, true);
+    expect(eq(field.view(), "ID=00C0FFEE;LEN=0042;OK=1"sv));
+    expect(field == "ID=00C0FFEE;LEN=0042;OK=1"sv);
+  };
+};
+
+} // namespace
@@ -0,0 +1,93 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "ctf/format_stream.hpp"
+
+#include <boost/ut.hpp>
+
+#include <list>
+#include <numeric>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+template <class Generator> std::vector<std::string> chunks(Generator &&g) {
+  std::vector<std::string> result;
+  for (std::string_view chunk : g)
+    result.emplace_back(chunk);
+  return result;
+}
+
+std::string join(const std::vector<std::string> &chunks) {
+  return std::accumulate(chunks.begin(), chunks.end(), std::string{});
+}
+
+boost::ut::suite<"format_stream"> format_stream = [] {
+  using namespace boost::ut;
+  using namespace std::literals::string_view_literals;
+
+  "small output"_test = [] {
+    auto result = chunks(ctf::format_stream<"hello {}!">("world"));
+    expect(eq(result.size(), 1u));
+    expect(eq(result[0], "hello world!"sv));
+
+    expect(chunks(ctf::format_stream<"">()).empty());
+  };
+
+  "chunk size"_test = [] {
+    auto result = chunks(ctf::format_stream<"{}{}{}", 4>(12345, 'a', "bcdefg"));
+    expect(eq(result.size(), 3u));
+    expect(eq(result[0], "1234"sv));
+    expect(eq(result[1], "5abc"sv));
+    expect(eq(result[2], "defg"sv));
+  };
+
+  "range"_test = [] {
+    std::vector<int> input(10'000);
+    std::iota(input.begin(), input.end(), 0);
+
+    auto result = chunks(ctf::format_stream<"values {}.", 64>(input));
+    std::string expected = ctf::format<"values {}.">(input);
+    expect(eq(join(result), expected));
+    expect(eq(result.size(), (expected.size() + 63) / 64));
+    for (std::size_t i = 0; i + 1 < result.size(); ++i)
+      expect(eq(result[i].size(), 64u));
+  };
+
+  "range elements"_test = [] {
+    std::vector<std::string> strings{"a", "b\n", "c"};
+    expect(eq(join(chunks(ctf::format_stream<"{}", 2>(strings))),
+              R"(["a", "b\n", "c"])"sv));
+
+    std::list<char> characters{'x', 'y'};
+    expect(eq(join(chunks(ctf::format_stream<"{0:}", 2>(characters))),
+              "['x', 'y']"sv));
+
+    std::vector<std::vector<int>> nested{{1, 2}, {}, {3}};
+    expect(eq(join(chunks(ctf::format_stream<"{}", 3>(nested))),
+              "[[1, 2], [], [3]]"sv));
+
+    expect(eq(join(chunks(ctf::format_stream<"{}", 3>(std::vector<int>{}))),
+              "[]"sv));
+  };
+
+  "range with format-spec"_test = [] {
+    std::vector<int> input{10, 11, 12};
+    expect(eq(join(chunks(ctf::format_stream<"{::x}|{:n}", 2>(input, input))),
+              "[a, b, c]|10, 11, 12"sv));
+  };
+
+  "arguments"_test = [] {
+    // The rvalue is stored in the generator.
+    auto generator = ctf::format_stream<"{}">(std::vector<int>{1, 2, 3});
+    expect(eq(join(chunks(generator)), "[1, 2, 3]"sv));
+  };
+};
+
+} // namespace
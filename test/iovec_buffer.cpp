@@ -0,0 +1,80 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "ctf/iovec_buffer.hpp"
+
+#include <boost/ut.hpp>
+
+#include <string>
+#include <string_view>
+
+#include <sys/uio.h>
+#include <unistd.h>
+
+namespace {
+
+std::string_view entry(const iovec &iov) {
+  return {static_cast<const char *>(iov.iov_base), iov.iov_len};
+}
+
+boost::ut::suite<"format_iov"> format_iov = [] {
+  using namespace boost::ut;
+  using namespace std::literals::string_view_literals;
+
+  "entries"_test = [] {
+    ctf::iovec_buffer buffer;
+    ctf::format_iov<"hello {}{}, answer {:#x}!">(buffer, "wor", "ld", 42);
+
+    auto iov = buffer.iov();
+    expect(eq(iov.size(), 5u));
+    expect(eq(entry(iov[0]), "hello "sv));
+    expect(eq(entry(iov[1]), "world"sv));
+    expect(eq(entry(iov[2]), ", answer "sv));
+    expect(eq(entry(iov[3]), "0x2a"sv));
+    expect(eq(entry(iov[4]), "!"sv));
+    expect(eq(buffer.size(), 25u));
+  };
+
+  "literals are not copied"_test = [] {
+    ctf::iovec_buffer buffer;
+    ctf::format_iov<"hello {}">(buffer, 1);
+    ctf::format_iov<"hello {}">(buffer, 2);
+
+    auto iov = buffer.iov();
+    expect(eq(iov.size(), 4u));
+    expect(iov[0].iov_base == iov[2].iov_base);
+    expect(iov[1].iov_base != iov[3].iov_base);
+
+    buffer.clear();
+    expect(buffer.iov().empty());
+  };
+
+  "writev"_test = [] {
+    ctf::iovec_buffer buffer;
+    std::string text(1000, 'x');
+    for (int i = 0; i != 3; ++i)
+      ctf::format_iov<"{}: {}\n">(buffer, i, text);
+
+    int fds[2];
+    expect(::pipe(fds) == 0);
+    auto iov = buffer.iov();
+    expect(eq(::writev(fds[1], iov.data(), iov.size()),
+              static_cast<ssize_t>(buffer.size())));
+    ::close(fds[1]);
+
+    std::string result;
+    char data[512];
+    for (ssize_t n = ::read(fds[0], data, sizeof(data)); n > 0;
+         n = ::read(fds[0], data, sizeof(data)))
+      result.append(data, n);
+    ::close(fds[0]);
+
+    expect(eq(result, "0: " + text + "\n1: " + text + "\n2: " + text + '\n'));
+  };
+};
+
+} // namespace
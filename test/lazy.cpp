@@ -0,0 +1,103 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "ctf/lazy.hpp"
+
+#include <boost/ut.hpp>
+
+#include <format>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+
+// Counts the number of times it is formatted.
+struct counted {
+  int *count;
+};
+
+} // namespace
+
+template <> struct std::formatter<counted, char> {
+  constexpr auto parse(std::format_parse_context &ctx) { return ctx.begin(); }
+
+  template <class FormatContext>
+  auto format(const counted &value, FormatContext &ctx) const {
+    ++*value.count;
+    return std::format_to(ctx.out(), "counted");
+  }
+};
+
+namespace {
+
+struct recording_sink {
+  void write(std::span<const char> data) {
+    blocks.emplace_back(data.data(), data.size());
+  }
+
+  std::vector<std::string> blocks;
+};
+
+boost::ut::suite<"lazy"> lazy = [] {
+  using namespace boost::ut;
+  using namespace std::literals::string_view_literals;
+
+  "only formatted when used"_test = [] {
+    int count = 0;
+    {
+      auto message = ctf::lazy<"value {}">(counted{&count});
+      (void)message;
+    }
+    expect(eq(count, 0));
+
+    auto message = ctf::lazy<"value {}">(counted{&count});
+    std::string str = message;
+    expect(eq(str, "value counted"sv));
+    expect(eq(count, 1));
+    expect(eq(message.str(), "value counted"sv));
+    expect(eq(count, 2));
+  };
+
+  "arguments"_test = [] {
+    std::string world = "world";
+    // An lvalue is stored by reference.
+    auto message = ctf::lazy<"hello {} {}">(world, 42);
+    world = "there";
+    expect(eq(message.str(), "hello there 42"sv));
+
+    // An rvalue is stored by value.
+    auto temporary = ctf::lazy<"hello {}">(std::string{"world"});
+    expect(eq(temporary.str(), "hello world"sv));
+  };
+
+  "nested"_test = [] {
+    auto inner = ctf::lazy<"[{:#x}]">(42);
+    expect(eq(ctf::format<"a {} b">(inner), "a [0x2a] b"sv));
+    expect(eq(ctf::format<"{}{}">(inner, ctf::lazy<"{}">(true)),
+              "[0x2a]true"sv));
+
+    // The nested output is written in the sink, not in a temporary string.
+    recording_sink sink;
+    ctf::format_to<"a {} b">(sink, inner);
+    std::string output;
+    for (const auto &block : sink.blocks)
+      output += block;
+    expect(eq(output, "a [0x2a] b"sv));
+    expect(sink.blocks.size() > 3u);
+  };
+
+  "sink"_test = [] {
+    std::string output;
+    ctf::string_sink sink{output};
+    ctf::format_to(sink, ctf::lazy<"hello {}">("world"));
+    expect(eq(output, "hello world"sv));
+  };
+};
+
+} // namespace
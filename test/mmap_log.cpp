@@ -0,0 +1,162 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "ctf/mmap_log.hpp"
+
+#include <boost/ut.hpp>
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <span>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+static_assert(ctf::sink<ctf::mmap_log>);
+
+namespace {
+
+// A file in the temporary directory, removed on destruction.
+struct temporary_file {
+  temporary_file() { ::close(::mkstemp(path)); }
+  ~temporary_file() { ::unlink(path); }
+
+  std::string read() const {
+    std::ifstream stream{path, std::ios::binary};
+    return {std::istreambuf_iterator<char>{stream}, {}};
+  }
+
+  char path[32] = "/tmp/ctf-mmap_log-XXXXXX";
+};
+
+boost::ut::suite<"mmap_log"> mmap_log = [] {
+  using namespace boost::ut;
+  using namespace std::literals::string_view_literals;
+
+  "append"_test = [] {
+    temporary_file file;
+    {
+      ctf::mmap_log log{file.path};
+      ctf::format_to<"hello {}\n">(log, "world");
+      ctf::format_to<"answer {:#x}\n">(log, 42);
+      expect(eq(log.size(), 22u));
+    }
+    expect(eq(file.read(), "hello world\nanswer 0x2a\n"sv));
+
+    {
+      ctf::mmap_log log{file.path};
+      ctf::format_to<"{}\n">(log, true);
+    }
+    expect(eq(file.read(), "hello world\nanswer 0x2a\ntrue\n"sv));
+  };
+
+  "multiple chunks"_test = [] {
+    temporary_file file;
+    std::string text(10'000, 'x');
+    {
+      // The chunk size is rounded up to the page size.
+      ctf::mmap_log log{file.path, 1};
+      for (int i = 0; i != 3; ++i)
+        ctf::format_to<"{}:{}\n">(log, i, text);
+    }
+    expect(eq(file.read(),
+              "0:" + text + "\n1:" + text + "\n2:" + text + '\n'));
+  };
+
+  "sink"_test = [] {
+    temporary_file file;
+    {
+      ctf::mmap_log log{file.path};
+      log.write(std::span<const char>{"hello ", 6});
+      log.write(std::span<const char>{"world\n", 6});
+    }
+    expect(eq(file.read(), "hello world\n"sv));
+  };
+
+  "bounded output"_test = [] {
+    temporary_file file;
+    std::string text(4090, 'x');
+    {
+      ctf::mmap_log log{file.path, 4096};
+      log.append(text);
+      // The output crosses the end of the first region.
+      ctf::format_to<"{}\n">(log, 42);
+      ctf::format_to<"{:#x}\n">(log, 42);
+      expect(eq(log.size(), 4090u + 3u + 5u));
+    }
+    expect(eq(file.read(), text + "42\n0x2a\n"));
+  };
+
+  "concurrent"_test = [] {
+    temporary_file file;
+    {
+      ctf::mmap_log log{file.path, 4096};
+      std::vector<std::thread> threads;
+      for (int t = 0; t != 4; ++t)
+        threads.emplace_back([&log, t] {
+          for (int i = 0; i != 1000; ++i)
+            ctf::format_to<"{:{}}\n">(log, t, 10 + t);
+        });
+      for (auto &thread : threads)
+        thread.join();
+    }
+
+    std::string output = file.read();
+    expect(eq(output.size(), (11u + 12u + 13u + 14u) * 1000u));
+    // Validates every line is written as one block.
+    std::string_view lines = output;
+    std::size_t count[4] = {};
+    while (!lines.empty()) {
+      std::size_t size = lines.find('\n');
+      int t = lines[size - 1] - '0';
+      expect(eq(size, 10u + t));
+      ++count[t];
+      lines.remove_prefix(size + 1);
+    }
+    expect(
+        std::ranges::all_of(count, [](std::size_t c) { return c == 1000; }));
+  };
+
+  "concurrent bounded output"_test = [] {
+    temporary_file file;
+    {
+      ctf::mmap_log log{file.path, 4096};
+      std::vector<std::thread> threads;
+      for (int t = 0; t != 4; ++t)
+        threads.emplace_back([&log, t] {
+          for (int i = 0; i != 1000; ++i)
+            ctf::format_to<"{} {}\n">(log, i, t);
+        });
+      for (auto &thread : threads)
+        thread.join();
+    }
+
+    // The log contains only the formatted lines.
+    std::string output = file.read();
+    std::size_t size = 0;
+    for (int i = 0; i != 1000; ++i)
+      size += 4 * (ctf::format<"{}">(i).size() + 3);
+    expect(eq(output.size(), size));
+    std::string_view lines = output;
+    std::size_t count[4] = {};
+    while (!lines.empty()) {
+      std::size_t size = lines.find('\n');
+      int t = lines[size - 1] - '0';
+      expect(ctf::format<"{} {}">(count[t], t) == lines.substr(0, size));
+      ++count[t];
+      lines.remove_prefix(size + 1);
+    }
+    expect(
+        std::ranges::all_of(count, [](std::size_t c) { return c == 1000; }));
+  };
+};
+
+} // namespace
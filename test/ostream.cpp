@@ -0,0 +1,82 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "ctf/ostream.hpp"
+
+#include <boost/ut.hpp>
+
+#include <ios>
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+
+namespace {
+
+// A stream buffer without a put area, every write uses sputn or sputc.
+struct unbuffered : std::streambuf {
+  int_type overflow(int_type c) override {
+    if (full)
+      return traits_type::eof();
+    output.push_back(traits_type::to_char_type(c));
+    return c;
+  }
+
+  std::streamsize xsputn(const char *data, std::streamsize size) override {
+    if (full)
+      return 0;
+    output.append(data, size);
+    return size;
+  }
+
+  std::string output;
+  bool full = false;
+};
+
+boost::ut::suite<"ostream"> ostream = [] {
+  using namespace boost::ut;
+  using namespace std::literals::string_view_literals;
+
+  "put area"_test = [] {
+    std::ostringstream os;
+    ctf::format_to<"hello {}">(os, "world");
+    ctf::format_to<", answer {:#x}">(os, 42);
+    expect(os.good());
+    expect(eq(os.view(), "hello world, answer 0x2a"sv));
+
+    std::string text(1000, 'x');
+    ctf::format_to<"|{}|">(os, text);
+    expect(eq(os.str(), "hello world, answer 0x2a|" + text + '|'));
+
+    std::wostringstream wos;
+    ctf::format_to<L"hello {}">(wos, L"world");
+    expect(wos.view() == L"hello world"sv);
+  };
+
+  "without put area"_test = [] {
+    unbuffered buffer;
+    std::ostream os{&buffer};
+    ctf::format_to<"hello {:>7}">(os, "world");
+    expect(os.good());
+    expect(eq(buffer.output, "hello   world"sv));
+  };
+
+  "failure"_test = [] {
+    unbuffered buffer;
+    buffer.full = true;
+    std::ostream os{&buffer};
+    ctf::format_to<"hello {}">(os, "world");
+    expect(os.bad());
+
+    os.clear();
+    os.exceptions(std::ios_base::badbit);
+    expect(throws<std::ios_base::failure>(
+        [&] { ctf::format_to<"hello {}">(os, "world"); }));
+  };
+};
+
+} // namespace
@@ -0,0 +1,80 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "ctf/print.hpp"
+
+#include <boost/ut.hpp>
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+#include <unistd.h>
+
+namespace {
+
+std::string read(std::FILE *stream) {
+  std::fflush(stream);
+  std::rewind(stream);
+  std::string result;
+  for (int c = std::fgetc(stream); c != EOF; c = std::fgetc(stream))
+    result.push_back(c);
+  return result;
+}
+
+std::string read(int fd) {
+  std::string result;
+  char buffer[512];
+  for (ssize_t n = ::read(fd, buffer, sizeof(buffer)); n > 0;
+       n = ::read(fd, buffer, sizeof(buffer)))
+    result.append(buffer, n);
+  return result;
+}
+
+boost::ut::suite<"print"> print = [] {
+  using namespace boost::ut;
+  using namespace std::literals::string_view_literals;
+
+  "FILE"_test = [] {
+    std::FILE *stream = std::tmpfile();
+    expect(stream != nullptr);
+
+    ctf::print<"hello {}">(stream, "world");
+    ctf::println<"; answer {:#x}">(stream, 42);
+    ctf::println<"">(stream);
+    expect(eq(read(stream), "hello world; answer 0x2a\n\n"sv));
+
+    std::fclose(stream);
+  };
+
+  "FILE larger than the buffer"_test = [] {
+    std::FILE *stream = std::tmpfile();
+    expect(stream != nullptr);
+
+    std::string text(3 * ctf::print_buffer_size + 5, 'x');
+    ctf::println<"<{}>">(stream, text);
+    expect(eq(read(stream), '<' + text + ">\n"));
+
+    std::fclose(stream);
+  };
+
+  "file descriptor"_test = [] {
+    int fds[2];
+    expect(::pipe(fds) == 0);
+
+    ctf::print_fd<"hello {}">(fds[1], "world");
+    ctf::println_fd<"; answer {:#x}">(fds[1], 42);
+    std::string text(2 * ctf::print_buffer_size, 'x');
+    ctf::println_fd<"{}">(fds[1], text);
+    ::close(fds[1]);
+    expect(eq(read(fds[0]), "hello world; answer 0x2a\n" + text + '\n'));
+
+    ::close(fds[0]);
+  };
+};
+
+} // namespace
@@ -0,0 +1,109 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "ctf/printf_format.hpp"
+
+#include <boost/ut.hpp>
+
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+static_assert(ctf::printf_valid<"">);
+static_assert(ctf::printf_valid<"%d", int>);
+static_assert(ctf::printf_valid<"%ld %llu %hhx %zu", long, unsigned long long,
+                                unsigned char, std::size_t>);
+static_assert(!ctf::printf_valid<"%d">);
+static_assert(!ctf::printf_valid<"%d", int, int>);
+static_assert(!ctf::printf_valid<"%d", double>);
+static_assert(!ctf::printf_valid<"%d", const char *>);
+static_assert(!ctf::printf_valid<"%f", int>);
+static_assert(!ctf::printf_valid<"%s", int>);
+static_assert(ctf::printf_valid<"%s", std::string>);
+static_assert(!ctf::printf_valid<"%c", double>);
+static_assert(!ctf::printf_valid<"%p", int>);
+static_assert(ctf::printf_valid<"%p", int *>);
+static_assert(ctf::printf_valid<"%p %p", const char *, char[4]>);
+static_assert(!ctf::printf_valid<"%p", std::string>);
+static_assert(!ctf::printf_valid<"%*d", int>);
+static_assert(!ctf::printf_valid<"%*d", double, int>);
+static_assert(!ctf::printf_valid<"%.3d", int>);
+static_assert(!ctf::printf_valid<"%n", int *>);
+static_assert(!ctf::printf_valid<"%q", int>);
+static_assert(!ctf::printf_valid<"%", int>);
+static_assert(!ctf::printf_valid<"%5", int>);
+
+namespace {
+
+template <class... Args>
+std::string c_format(const char *fmt, const Args &...args) {
+  char buffer[256];
+  int size = std::snprintf(buffer, sizeof(buffer), fmt, args...);
+  return {buffer, static_cast<std::size_t>(size)};
+}
+
+boost::ut::suite<"printf_format"> printf_format = [] {
+  using namespace boost::ut;
+  using namespace std::literals::string_view_literals;
+
+  "conversions"_test = [] {
+    expect(eq(ctf::printf_format<"%08x %-20s %.3f">(0xbeefu, "name", 3.14159),
+              c_format("%08x %-20s %.3f", 0xbeefu, "name", 3.14159)));
+    expect(eq(ctf::printf_format<"%d|%5d|%-5d|%+d|% d|%05d">(1, 2, 3, 4, 5, -6),
+              c_format("%d|%5d|%-5d|%+d|% d|%05d", 1, 2, 3, 4, 5, -6)));
+    expect(eq(ctf::printf_format<"%i %u %o %#o %x %#X">(-1, 7u, 8, 8, 255, 255),
+              c_format("%i %u %o %#o %x %#X", -1, 7u, 8, 8, 255, 255)));
+    expect(eq(ctf::printf_format<"%e %E %g %G %10.2f %-10.1e|">(
+                  1234.5, 0.00012, 100000.0, 1e-10, 3.14159, 2.5),
+              c_format("%e %E %g %G %10.2f %-10.1e|", 1234.5, 0.00012,
+                       100000.0, 1e-10, 3.14159, 2.5)));
+    expect(eq(ctf::printf_format<"%c%c|%3c|%-3c|">('a', 98, 'c', 'd'),
+              c_format("%c%c|%3c|%-3c|", 'a', 98, 'c', 'd')));
+    expect(eq(ctf::printf_format<"%s|%10s|%-10s|%.2s|">("abc", "abc", "abc",
+                                                         "abc"),
+              c_format("%s|%10s|%-10s|%.2s|", "abc", "abc", "abc", "abc")));
+
+    int i = 0;
+    expect(eq(ctf::printf_format<"%p">(&i), c_format("%p", &i)));
+  };
+
+  "alternate form of zero"_test = [] {
+    // printf writes no prefix for zero.
+    expect(eq(ctf::printf_format<"%#x|%#X|%#o|%#5x|%#05x|%#x">(0, 0u, 0, 0, 0,
+                                                              16),
+              c_format("%#x|%#X|%#o|%#5x|%#05x|%#x", 0, 0u, 0, 0, 0, 16)));
+    expect(eq(ctf::printf_format<"%#*x|">(4, 0), c_format("%#*x|", 4, 0)));
+  };
+
+  "pointer to a string"_test = [] {
+    const char *s = "abc";
+    char buffer[] = "def";
+    expect(eq(ctf::printf_format<"%p %s %p %s">(s, s, buffer, buffer),
+              c_format("%p %s %p %s", s, s, static_cast<void *>(buffer),
+                       buffer)));
+  };
+
+  "negative unsigned conversions"_test = [] {
+    expect(eq(ctf::printf_format<"%u %x">(-1, -2),
+              c_format("%u %x", -1, -2)));
+    expect(eq(ctf::printf_format<"%lx">(-1l), c_format("%lx", -1l)));
+  };
+
+  "dynamic width and precision"_test = [] {
+    expect(eq(ctf::printf_format<"%*d|%-*d|%.*f|%*.*f">(5, 42, 4, 7, 2, 3.14159,
+                                                        8, 1, 2.5),
+              c_format("%*d|%-*d|%.*f|%*.*f", 5, 42, 4, 7, 2, 3.14159, 8, 1,
+                       2.5)));
+  };
+
+  "literal text"_test = [] {
+    expect(eq(ctf::printf_format<"100%% {braces}">(), "100% {braces}"sv));
+    expect(eq(ctf::printf_format<"%s">(std::string{"string"}), "string"sv));
+  };
+};
+
+} // namespace
@@ -0,0 +1,99 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "ctf/runtime_format.hpp"
+
+#include <boost/ut.hpp>
+
+#include <format>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace {
+
+boost::ut::suite<"runtime_format"> runtime_format = [] {
+  using namespace boost::ut;
+  using namespace std::literals::string_view_literals;
+
+  "format"_test = [] {
+    expect(eq(ctf::runtime_format("hello world"), "hello world"sv));
+    expect(eq(ctf::runtime_format("{{hello}} {}", "world"), "{hello} world"sv));
+    expect(eq(ctf::runtime_format("{:>5}|{:#x}|{}", 'a', 42, true),
+              "    a|0x2a|true"sv));
+    expect(eq(ctf::runtime_format("{1} {0} {1}", std::string{"a"}, 1.5),
+              "1.5 a 1.5"sv));
+    expect(eq(ctf::runtime_format("{:*^{}}", 42, 6), "**42**"sv));
+
+    std::vector<int> v{1, 2, 3};
+    expect(eq(ctf::runtime_format("{::02}", v), "[01, 02, 03]"sv));
+  };
+
+  "same output as std::format"_test = [] {
+    for (std::string_view fmt : {"{}", "{:+}", "{:08.3f}", "{:e}", "[{:^12}]"})
+      expect(eq(ctf::runtime_format(fmt, 3.25),
+                std::vformat(fmt, std::make_format_args(3.25))));
+  };
+
+  "invalid format strings"_test = [] {
+    expect(throws<std::format_error>([] { ctf::runtime_format("{"); }));
+    expect(throws<std::format_error>([] { ctf::runtime_format("}"); }));
+    expect(throws<std::format_error>([] { ctf::runtime_format("{}"); }));
+    expect(throws<std::format_error>([] { ctf::runtime_format("{1}", 1); }));
+    expect(throws<std::format_error>([] { ctf::runtime_format("{0}{}", 1); }));
+    expect(throws<std::format_error>([] { ctf::runtime_format("{:d}", "a"); }));
+    expect(throws<std::format_error>([] { ctf::runtime_format("{:x", 1); }));
+    expect(throws<std::format_error>([] { ctf::runtime_format("{a}", 1); }));
+
+    // An invalid format string is not cached.
+    expect(throws<std::format_error>([] { ctf::runtime_format("{:q}", 1); }));
+    expect(throws<std::format_error>([] { ctf::runtime_format("{:q}", 1); }));
+  };
+
+  "cache"_test = [] {
+    // More format strings than the cache holds.
+    for (std::size_t i = 0; i != 2 * ctf::runtime_format_cache_size; ++i) {
+      std::string fmt = std::to_string(i) + " {}";
+      expect(eq(ctf::runtime_format(fmt, i), std::to_string(i) + ' ' +
+                                                 std::to_string(i)));
+    }
+
+    // The same format string with different argument types.
+    expect(eq(ctf::runtime_format("{:x}", 255), "ff"sv));
+    expect(throws<std::format_error>(
+        [] { ctf::runtime_format("{:x}", std::string{"a"}); }));
+  };
+
+  "threads"_test = [] {
+    std::vector<std::thread> threads;
+    std::vector<int> results(8);
+    for (std::size_t t = 0; t != results.size(); ++t)
+      threads.emplace_back([t, &results] {
+        bool result = true;
+        for (int i = 0; i != 1000; ++i) {
+          std::string fmt = std::to_string(i % 300) + " {}";
+          result &= ctf::runtime_format(fmt, t) ==
+                    std::to_string(i % 300) + ' ' + std::to_string(t);
+        }
+        results[t] = result;
+      });
+    for (std::thread &thread : threads)
+      thread.join();
+    for (int result : results)
+      expect(result == 1);
+  };
+
+  "sink"_test = [] {
+    std::string output;
+    ctf::string_sink sink{output};
+    ctf::runtime_format_to(sink, "{} {}", "answer", 42);
+    expect(eq(output, "answer 42"sv));
+  };
+};
+
+} // namespace
@@ -0,0 +1,91 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "ctf/scan.hpp"
+
+#include <boost/ut.hpp>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <tuple>
+
+namespace {
+
+boost::ut::suite<"scan"> scan = [] {
+  using namespace boost::ut;
+  using namespace std::literals::string_view_literals;
+
+  "integers"_test = [] {
+    auto result = ctf::scan<"{} {:x}", int, unsigned>("-42 ff");
+    expect(result.has_value());
+    expect(eq(std::get<0>(*result), -42));
+    expect(eq(std::get<1>(*result), 255u));
+
+    auto bases = ctf::scan<"{:b},{:o},{:X},{:d}", int, int, int, std::int8_t>(
+        "101,17,1F,-128");
+    expect(bases.has_value());
+    expect(*bases == std::tuple<int, int, int, std::int8_t>{5, 15, 31, -128});
+  };
+
+  "floating-point"_test = [] {
+    auto result = ctf::scan<"{}|{:e}|{:f}", double, float, double>(
+        "1.5|2.5e+01|0.125");
+    expect(result.has_value());
+    expect(*result == std::tuple<double, float, double>{1.5, 25.f, 0.125});
+  };
+
+  "strings"_test = [] {
+    auto result = ctf::scan<"{}={};{}", std::string_view, std::string, char>(
+        "key=some value;x");
+    expect(result.has_value());
+    expect(eq(std::get<0>(*result), "key"sv));
+    expect(eq(std::get<1>(*result), "some value"sv));
+    expect(eq(std::get<2>(*result), 'x'));
+
+    auto last = ctf::scan<"name: {}", std::string_view>("name: a b c");
+    expect(last.has_value());
+    expect(eq(std::get<0>(*last), "a b c"sv));
+  };
+
+  "arg-ids"_test = [] {
+    auto result = ctf::scan<"{1} {0}", int, bool>("true 7");
+    expect(result.has_value());
+    expect(*result == std::tuple<int, bool>{7, true});
+
+    auto escaped = ctf::scan<"{{{}}}", int>("{42}");
+    expect(escaped.has_value());
+    expect(eq(std::get<0>(*escaped), 42));
+  };
+
+  "errors"_test = [] {
+    auto literal = ctf::scan<"a={}", int>("b=1");
+    expect(!literal.has_value());
+    expect(literal.error().code == ctf::scan_errc::literal_mismatch);
+    expect(eq(literal.error().position, 0u));
+
+    auto invalid = ctf::scan<"a={}", int>("a=x");
+    expect(!invalid.has_value());
+    expect(invalid.error().code == ctf::scan_errc::invalid_value);
+    expect(eq(invalid.error().position, 2u));
+
+    auto range = ctf::scan<"{}", std::uint8_t>("256");
+    expect(!range.has_value());
+    expect(range.error().code == ctf::scan_errc::value_out_of_range);
+
+    auto trailing = ctf::scan<"{}", int>("12 ");
+    expect(!trailing.has_value());
+    expect(trailing.error().code == ctf::scan_errc::trailing_input);
+    expect(eq(trailing.error().position, 2u));
+
+    auto missing = ctf::scan<"{} {}", int, int>("12");
+    expect(!missing.has_value());
+    expect(missing.error().code == ctf::scan_errc::literal_mismatch);
+  };
+};
+
+} // namespace
@@ -0,0 +1,122 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "ctf/format.hpp"
+
+#include <boost/ut.hpp>
+
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <unistd.h>
+
+namespace {
+
+// Records the blocks written, this validates the literal text is written
+// with one call.
+struct recording_sink {
+  void write(std::span<const char> data) {
+    blocks.emplace_back(data.data(), data.size());
+  }
+  void reserve(std::size_t size) { reserved = size; }
+
+  std::vector<std::string> blocks;
+  std::size_t reserved = 0;
+};
+
+static_assert(ctf::sink<recording_sink>);
+static_assert(!ctf::sink<recording_sink, wchar_t>);
+static_assert(ctf::sink<ctf::string_sink<char>>);
+static_assert(ctf::sink<ctf::string_sink<wchar_t>, wchar_t>);
+static_assert(ctf::sink<ctf::fixed_buffer_sink<char>>);
+static_assert(ctf::sink<ctf::fd_sink>);
+static_assert(ctf::sink<ctf::counting_sink>);
+static_assert(ctf::sink<ctf::counting_sink, char32_t>);
+static_assert(ctf::sink<ctf::null_sink>);
+
+boost::ut::suite<"sink"> sink = [] {
+  using namespace boost::ut;
+  using namespace std::literals::string_view_literals;
+
+  "literal text"_test = [] {
+    recording_sink sink;
+    ctf::format_to<"hello {}!">(sink, 'x');
+    expect(eq(sink.blocks.size(), 3u));
+    expect(eq(sink.blocks[0], "hello "sv));
+    expect(eq(sink.blocks[1], "x"sv));
+    expect(eq(sink.blocks[2], "!"sv));
+    expect(eq(sink.reserved, 8u));
+
+    sink = {};
+    ctf::format_to<"hello {}!">(sink, "world");
+    expect(eq(sink.reserved, 7u));
+  };
+
+  "string"_test = [] {
+    std::string str = "answer: ";
+    ctf::string_sink sink{str};
+    ctf::format_to<"{}">(sink, 42);
+    ctf::format_to<", {:#x}">(sink, 42);
+    expect(eq(str, "answer: 42, 0x2a"sv));
+
+    std::wstring wstr;
+    ctf::string_sink wsink{wstr};
+    ctf::format_to<L"{:_^7}">(wsink, L"abc");
+    expect(wstr == L"__abc__"sv);
+  };
+
+  "fixed buffer"_test = [] {
+    char buffer[10];
+    ctf::fixed_buffer_sink sink{buffer};
+    ctf::format_to<"{} {}">(sink, "hello", 42);
+    expect(eq(sink.view(), "hello 42"sv));
+    expect(!sink.truncated());
+
+    ctf::format_to<"{}">(sink, "world");
+    expect(eq(sink.view(), "hello 42wo"sv));
+    expect(sink.truncated());
+  };
+
+  "file descriptor"_test = [] {
+    int fds[2];
+    expect(::pipe(fds) == 0);
+    {
+      ctf::fd_sink sink{fds[1]};
+      ctf::format_to<"hello {}">(sink, "world");
+      std::string text(2 * ctf::fd_sink_buffer_size, 'x');
+      ctf::format_to<"\n{}\n">(sink, text);
+      sink.flush();
+    }
+    ::close(fds[1]);
+
+    std::string result;
+    char buffer[512];
+    for (ssize_t n = ::read(fds[0], buffer, sizeof(buffer)); n > 0;
+         n = ::read(fds[0], buffer, sizeof(buffer)))
+      result.append(buffer, n);
+    ::close(fds[0]);
+
+    expect(eq(result, "hello world\n" +
+                          std::string(2 * ctf::fd_sink_buffer_size, 'x') +
+                          '\n'));
+  };
+
+  "counting"_test = [] {
+    ctf::counting_sink sink;
+    ctf::format_to<"hello {:>10} {}">(sink, "world", 42);
+    expect(eq(sink.size(), 19u));
+  };
+
+  "null"_test = [] {
+    ctf::null_sink sink;
+    ctf::format_to<"hello {}">(sink, "world");
+  };
+};
+
+} // namespace
@@ -0,0 +1,59 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "ctf/structured.hpp"
+
+#include <boost/ut.hpp>
+
+#include <limits>
+#include <string>
+#include <string_view>
+
+namespace {
+
+boost::ut::suite<"structured"> structured = [] {
+  using namespace boost::ut;
+  using namespace std::literals::string_view_literals;
+
+  "json"_test = [] {
+    std::string text;
+    std::string record;
+    ctf::string_sink text_sink{text};
+    ctf::string_sink record_sink{record};
+    ctf::format_structured<"{} copied {:#x} bytes in {:.2f}s", "user",
+                           "bytes", "time">(text_sink, record_sink, "alice",
+                                            4096, 1.375);
+    expect(eq(text, "alice copied 0x1000 bytes in 1.38s"sv));
+    expect(eq(record, R"({"user":"alice","bytes":4096,"time":1.375})"sv));
+  };
+
+  "json escaping"_test = [] {
+    std::string text;
+    std::string record;
+    ctf::string_sink text_sink{text};
+    ctf::string_sink record_sink{record};
+    ctf::format_structured<"{1}: {0}", "message", "ok", "c", "nan">(
+        text_sink, record_sink, std::string{"a \"b\"\\\n\x01"}, true, 'x',
+        std::numeric_limits<double>::quiet_NaN());
+    expect(eq(text, "true: a \"b\"\\\n\x01"sv));
+    expect(eq(record, R"({"message":"a \"b\"\\\n\u0001",)"
+                      R"("ok":true,"c":"x","nan":null})"sv));
+  };
+
+  "logfmt"_test = [] {
+    std::string text;
+    std::string record;
+    ctf::string_sink text_sink{text};
+    ctf::string_sink record_sink{record};
+    ctf::format_logfmt<"{} {} {} {}", "level", "msg", "empty", "count">(
+        text_sink, record_sink, "info", "disk full", "", -3);
+    expect(eq(text, "info disk full  -3"sv));
+    expect(eq(record, R"(level=info msg="disk full" empty="" count=-3)"sv));
+  };
+};
+
+} // namespace
@@ -0,0 +1,99 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "ctf/text_template.hpp"
+
+#include <boost/ut.hpp>
+
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+
+// Repeats the string literal s 10 times.
+#define CTF_REPEAT_10(s) s s s s s s s s s s
+
+namespace {
+
+boost::ut::suite<"text_template"> text_template = [] {
+  using namespace boost::ut;
+  using namespace std::literals::string_view_literals;
+
+  "fields"_test = [] {
+    expect(eq(ctf::render<"hello {name}, {count:04} {{}}">(
+                  ctf::arg<"name">("world"sv), ctf::arg<"count">(42)),
+              "hello world, 0042 {}"sv));
+    expect(eq(ctf::render<"{b}{a}{b}">(ctf::arg<"a">(1), ctf::arg<"b">('x')),
+              "x1x"sv));
+    expect(eq(ctf::render<"no tags">(), "no tags"sv));
+  };
+
+  "sections"_test = [] {
+    std::vector<int> items{1, 2, 3};
+    expect(eq(ctf::render<"<ul>{#items}<li>{.:02}</li>{/items}</ul>">(
+                  ctf::arg<"items">(items)),
+              "<ul><li>01</li><li>02</li><li>03</li></ul>"sv));
+
+    std::vector<int> empty;
+    expect(eq(ctf::render<"[{#items}{.}{/items}]">(ctf::arg<"items">(empty)),
+              "[]"sv));
+
+    // The arguments remain available in the body.
+    expect(eq(ctf::render<"{#items}{sep}{.}{/items}">(
+                  ctf::arg<"items">(items), ctf::arg<"sep">(',')),
+              ",1,2,3"sv));
+  };
+
+  "tuple elements"_test = [] {
+    std::vector<std::tuple<std::string, std::vector<int>>> rows{
+        {"a", {1, 2}}, {"b", {}}, {"c", {3}}};
+    expect(eq(ctf::render<"{#rows}{.0}:{#.1} {.}{/.1}{^.1} -{/.1};{/rows}">(
+                  ctf::arg<"rows">(rows)),
+              "a: 1 2;b: -;c: 3;"sv));
+  };
+
+  "conditionals"_test = [] {
+    auto page = [](bool admin, int count) {
+      return ctf::render<"{?admin}[admin]{/admin}{^admin}[user]{/admin}"
+                         "{?count} count={count}{/count}">(
+          ctf::arg<"admin">(admin), ctf::arg<"count">(count));
+    };
+    expect(eq(page(true, 0), "[admin]"sv));
+    expect(eq(page(false, 7), "[user] count=7"sv));
+
+    std::vector<std::string> errors{"x"};
+    expect(eq(ctf::render<"{?errors}errors:{#errors} {.}{/errors}{/errors}">(
+                  ctf::arg<"errors">(errors)),
+              "errors: x"sv));
+  };
+
+  "sink"_test = [] {
+    std::string output;
+    ctf::string_sink sink{output};
+    ctf::render_to<"{#items}{.} {/items}">(sink,
+                                           ctf::arg<"items">("abc"sv));
+    expect(eq(output, "a b c "sv));
+  };
+
+  "large template"_test = [] {
+    // Every repetition adds several nodes and a section, this exceeds the
+    // instantiation depth of a recursive parser.
+    std::vector<int> items{1, 2};
+    std::string output =
+        ctf::render<CTF_REPEAT_10(CTF_REPEAT_10("<div class=\"item\">{title}"
+                                                "{#items}<span>{.}</span>"
+                                                "{/items}</div>\n"))>(
+            ctf::arg<"title">("t"sv), ctf::arg<"items">(items));
+
+    std::string expected;
+    for (int i = 0; i != 100; ++i)
+      expected += "<div class=\"item\">t<span>1</span><span>2</span></div>\n";
+    expect(eq(output, expected));
+  };
+};
+
+} // namespace
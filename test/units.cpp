@@ -0,0 +1,97 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "ctf/format.hpp"
+#include "ctf/units.hpp"
+
+#include <boost/ut.hpp>
+
+#include <chrono>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+
+// A character is not a number of bytes, char and wchar_t are unsigned on some
+// platforms.
+static_assert(ctf::detail::unit_integer<unsigned char>);
+static_assert(!ctf::detail::unit_integer<char>);
+static_assert(!ctf::detail::unit_integer<wchar_t>);
+static_assert(!ctf::detail::unit_integer<char8_t>);
+
+namespace {
+
+boost::ut::suite<"units"> units = [] {
+  using namespace boost::ut;
+  using namespace std::literals::string_view_literals;
+  using namespace std::chrono_literals;
+
+  "binary bytes"_test = [] {
+    expect(eq(ctf::format<"{:iB}">(0u), "0 B"sv));
+    expect(eq(ctf::format<"{:iB}">(1023u), "1023 B"sv));
+    expect(eq(ctf::format<"{:iB}">(1024u), "1.0 KiB"sv));
+    expect(eq(ctf::format<"{:iB}">(std::uint64_t(1'288'490'189)), "1.2 GiB"sv));
+    expect(eq(ctf::format<"{:.2iB}">(std::numeric_limits<std::uint64_t>::max()),
+              "16.00 EiB"sv));
+    // Rounding to the next unit.
+    expect(eq(ctf::format<"{:iB}">(1'048'575u), "1.0 MiB"sv));
+  };
+
+  "si bytes"_test = [] {
+    expect(eq(ctf::format<"{:sB}">(999u), "999 B"sv));
+    expect(eq(ctf::format<"{:sB}">(1000u), "1.0 kB"sv));
+    expect(eq(ctf::format<"{:.3sB}">(1'234'567u), "1.235 MB"sv));
+    expect(eq(ctf::format<"{:.0sB}">(2'500'000'000u), "3 GB"sv));
+  };
+
+  "duration"_test = [] {
+    expect(eq(ctf::format<"{:hd}">(350ms), "350.0 ms"sv));
+    expect(eq(ctf::format<"{:.0hd}">(350ms), "350 ms"sv));
+    expect(eq(ctf::format<"{:hd}">(999ns), "999 ns"sv));
+    expect(eq(ctf::format<"{:hd}">(-1500ms), "-1.5 s"sv));
+    expect(eq(ctf::format<"{:hd}">(90s), "1.5 min"sv));
+    expect(eq(ctf::format<"{:.2hd}">(36h), "1.50 d"sv));
+    expect(eq(ctf::format<"{:hd}">(std::chrono::duration<double>(0.25)),
+              "250.0 ms"sv));
+  };
+
+  "long duration"_test = [] {
+    // These durations don't fit in std::chrono::nanoseconds.
+    expect(eq(ctf::format<"{:hd}">(std::chrono::days{200'000}),
+              "200000.0 d"sv));
+    expect(eq(ctf::format<"{:hd}">(-std::chrono::days{200'000}),
+              "-200000.0 d"sv));
+    expect(eq(ctf::format<"{:hd}">(std::chrono::years{1'000}), "365242.5 d"sv));
+    // Longer durations are written as the largest duration.
+    expect(eq(ctf::format<"{:.9hd}">(std::chrono::days::max()),
+              "9223372036.000000000 d"sv));
+    expect(eq(ctf::format<"{:hd}">(std::chrono::duration<double>(-1e300)),
+              "-9223372036.0 d"sv));
+  };
+
+  "width"_test = [] {
+    expect(eq(ctf::format<"[{:10iB}]">(2048u), "[   2.0 KiB]"sv));
+    expect(eq(ctf::format<"[{:*<10hd}]">(2s), "[2.0 s*****]"sv));
+    expect(eq(ctf::format<"[{:{}sB}]">(5u, 5), "[  5 B]"sv));
+  };
+
+  "other display types"_test = [] {
+    // The unit display types don't change the other format-specs.
+    expect(eq(ctf::format<"{:#x}">(255u), "0xff"sv));
+    expect(eq(ctf::format<"{:%S}">(2s), "02"sv));
+  };
+
+  "valid"_test = [] {
+    expect(ctf::valid<"{:>12.3iB}", unsigned>);
+    expect(ctf::valid<"{:.9hd}", std::chrono::seconds>);
+    expect(!ctf::valid<"{:.10sB}", unsigned>);
+    expect(!ctf::valid<"{:.{}iB}", unsigned, int>);
+    expect(!ctf::valid<"{:+iB}", unsigned>);
+    expect(!ctf::valid<"{:xiB}", unsigned>);
+  };
+};
+
+} // namespace
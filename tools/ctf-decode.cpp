@@ -0,0 +1,59 @@
+//===----------------------------------------------------------------------===//
+//
+// Part of the CTF project, under the Apache License v2.0 with LLVM Exceptions.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+// Renders a binary log written by ctf::capture.
+//
+// The decoders are registered by the call sites linked in the executable. The
+// ctf_add_decoder CMake function creates this tool for the call sites of an
+// application.
+
+#include "ctf/binary_log.hpp"
+#include "ctf/print.hpp"
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <span>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+int main(int argc, char **argv) {
+  if (argc != 2) {
+    ctf::println<"usage: {} <binary log>">(stderr, argv[0]);
+    return 1;
+  }
+
+  int fd = ::open(argv[1], O_RDONLY | O_CLOEXEC);
+  struct stat status;
+  if (fd < 0 || ::fstat(fd, &status) != 0) {
+    ctf::println<"{}: {}">(stderr, argv[1], std::strerror(errno));
+    return 1;
+  }
+
+  std::size_t size = status.st_size;
+  void *data = size ? ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0)
+                    : nullptr;
+  if (data == MAP_FAILED) {
+    ctf::println<"{}: {}">(stderr, argv[1], std::strerror(errno));
+    return 1;
+  }
+  ::close(fd);
+
+  try {
+    ctf::fd_sink out{STDOUT_FILENO};
+    ctf::decode_binary_log({static_cast<const std::byte *>(data), size}, out);
+    out.flush();
+  } catch (const std::exception &e) {
+    ctf::println<"{}: {}">(stderr, argv[1], e.what());
+    return 1;
+  }
+}